@@ -96,8 +96,14 @@ void set_rumble_frames() {
 }
 
 void rumble() {
+  // Wait until the wristband has room for a full packet of frames.
+  // By default that is once only half a packet is left to play, so the
+  // next packet arrives before the motors run dry without piling up
+  // latency in the motor queue.
+  while (!NeoBluefruit.canAccept(NeoBluefruit.max_frames_per_bt_package())) {
+    yield();
+  }
   NeoBluefruit.vibrateMotors(rumble_frames, NeoBluefruit.max_frames_per_bt_package());
-  delay((NeoBluefruit.max_frames_per_bt_package()) * NeoBluefruit.firmware_frame_duration());
 }
 
 /* Callbacks */
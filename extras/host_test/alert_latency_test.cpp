@@ -0,0 +1,208 @@
+/*
+ * Copyright 2020 Neosensory, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Please note that while this Neosensory SDK has an Apache 2.0 license,
+ * usage of the Neosensory API to interface with Neosensory products is
+ * still  subject to the Neosensory developer terms of service located at:
+ * https://neosensory.com/legal/dev-terms-service/
+ *
+ * alert_latency_test.cpp - Simulates a wristband fed a saturated stream of
+ * multi-frame packets and measures how long an alert takes to start
+ * vibrating, with playAlert() and with the alert queued behind the stream.
+ */
+
+#include <algorithm>
+#include <deque>
+#include "neosensory_bluefruit.h"
+#include "mock_link.h"
+
+static const int kMotors = 4;
+static const int kFrameMs = 16;
+static const int kTrials = 200;
+static const float kStreamLevel = 0.3f;
+
+static NeosensoryBluefruit neo;
+
+/** @brief Model of the wristband: a queue of frames played one per frame
+ *	duration, fed by the writes recorded by the mock link.
+ */
+struct Wristband {
+	std::deque<std::string> queue;
+	uint32_t next_frame_ms;
+	size_t writes_read;
+
+	void reset(void) {
+		queue.clear();
+		next_frame_ms = mock_millis;
+		writes_read = 0;
+	}
+
+	/** @brief Applies writes made since the last call */
+	void receive(void) {
+		for (; writes_read < mock_writes.size(); writes_read++) {
+			const std::string& write = mock_writes[writes_read];
+			static const std::string vibrate = "motors vibrate ";
+			if (write.compare(0, vibrate.size(), vibrate) == 0) {
+				std::string frames = decode(write.substr(vibrate.size(),
+					write.size() - vibrate.size() - 1));
+				if (queue.empty() && (int32_t)(mock_millis - next_frame_ms) > 0) {
+					next_frame_ms = mock_millis;
+				}
+				for (size_t i = 0; i + kMotors <= frames.size(); i += kMotors) {
+					queue.push_back(frames.substr(i, kMotors));
+				}
+			} else if (write == "motors clear_queue\n") {
+				queue.clear();
+			}
+		}
+	}
+
+	/** @brief Plays frames due by now, and returns the time the first frame
+	 *	at full intensity started, or -1 if none did
+	 */
+	int64_t play(void) {
+		int64_t alert_start = -1;
+		while (!queue.empty() && (int32_t)(mock_millis - next_frame_ms) >= 0) {
+			if ((uint8_t)queue.front()[0] == neo.max_vibration && alert_start < 0) {
+				alert_start = next_frame_ms;
+			}
+			queue.pop_front();
+			next_frame_ms += kFrameMs;
+		}
+		return alert_start;
+	}
+
+	static std::string decode(const std::string& text) {
+		static const std::string alphabet =
+			"ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+		std::string bytes;
+		uint32_t bits = 0;
+		int num_bits = 0;
+		for (char c : text) {
+			size_t value = alphabet.find(c);
+			if (value == std::string::npos) {
+				break;
+			}
+			bits = (bits << 6) | value;
+			num_bits += 6;
+			if (num_bits >= 8) {
+				num_bits -= 8;
+				bytes += (char)((bits >> num_bits) & 0xFF);
+			}
+		}
+		return bytes;
+	}
+};
+
+struct Result {
+	int max_onset_ms;
+	double mean_onset_ms;
+	double mean_discarded;
+	int discard_mismatches;
+};
+
+/** @brief Streams full packets whenever canAccept() allows, fires an alert
+ *	at a random time, and measures when it starts on the wristband
+ *	@param[in] queue_depth max_frames_queued() to stream with
+ *	@param[in] use_play_alert True to send the alert with playAlert(), false
+ *	to queue it behind the stream with vibrateMotors()
+ */
+static Result runTrials(uint16_t queue_depth, bool use_play_alert) {
+	const int packet = neo.max_frames_per_bt_package();
+	static float stream_storage[64][kMotors];
+	static float alert_storage[8][kMotors];
+	float* stream[64];
+	float* alert[8];
+	for (int i = 0; i < 64; i++) {
+		stream[i] = stream_storage[i];
+		std::fill(stream_storage[i], stream_storage[i] + kMotors, kStreamLevel);
+	}
+	for (int i = 0; i < 8; i++) {
+		alert[i] = alert_storage[i];
+		std::fill(alert_storage[i], alert_storage[i] + kMotors, 1.0f);
+	}
+	Result result = {0, 0, 0, 0};
+	Wristband band;
+	srand(queue_depth);
+	for (int trial = 0; trial < kTrials; trial++) {
+		neo.motorsClearQueue();
+		neo.setMaxFramesQueued(queue_depth);
+		mockResetLink();
+		band.reset();
+		uint32_t alert_at = mock_millis + 2000 + rand() % 1000;
+		int64_t onset = -1;
+		while (onset < 0) {
+			if ((int32_t)(mock_millis - alert_at) < 0) {
+				if (neo.canAccept(packet)) {
+					neo.vibrateMotors(stream, packet);
+				}
+			} else if (mock_millis == alert_at) {
+				size_t queued = band.queue.size();
+				if (use_play_alert) {
+					neo.playAlert(alert, 8);
+					int discarded = neo.alertFramesDiscarded();
+					result.mean_discarded += discarded;
+					// The model and the wristband may disagree on the frame in progress
+					if (abs(discarded - (int)queued) > 1) {
+						result.discard_mismatches++;
+					}
+				} else {
+					neo.vibrateMotors(alert, 8);
+				}
+			}
+			band.receive();
+			onset = band.play();
+			neo.update();
+			mock_millis++;
+		}
+		int onset_ms = (int)(onset - alert_at);
+		result.max_onset_ms = std::max(result.max_onset_ms, onset_ms);
+		result.mean_onset_ms += onset_ms;
+	}
+	result.mean_onset_ms /= kTrials;
+	result.mean_discarded /= kTrials;
+	return result;
+}
+
+int main(void) {
+	mock_record_writes = true;
+	neo.connectCallback(1);
+	const int packet = neo.max_frames_per_bt_package();
+	const uint16_t depths[] = {(uint16_t)packet, neo.max_frames_queued(), (uint16_t)(packet * 2),
+		(uint16_t)(packet * 3)};
+	bool passed = true;
+	printf("Saturated stream of %d-frame packets, %d ms frames, %d alerts per row\n",
+		packet, kFrameMs, kTrials);
+	printf("%12s %22s %22s %18s\n", "queue depth", "queued onset mean/max",
+		"playAlert mean/max", "frames discarded");
+	for (uint16_t depth : depths) {
+		Result queued = runTrials(depth, false);
+		Result alert = runTrials(depth, true);
+		printf("%12d %13.1f / %4d ms %13.1f / %4d ms %18.1f\n", depth,
+			queued.mean_onset_ms, queued.max_onset_ms,
+			alert.mean_onset_ms, alert.max_onset_ms, alert.mean_discarded);
+		// playAlert must start at the next frame boundary, whatever is queued
+		if (alert.max_onset_ms > kFrameMs || alert.discard_mismatches > 0) {
+			printf("FAIL: alert onset %d ms, %d discard count mismatches\n",
+				alert.max_onset_ms, alert.discard_mismatches);
+			passed = false;
+		}
+	}
+	if (!passed) {
+		return 1;
+	}
+	printf("PASS alert_latency_test\n");
+	return 0;
+}
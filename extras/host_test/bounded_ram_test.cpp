@@ -0,0 +1,183 @@
+/*
+ * Copyright 2020 Neosensory, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Please note that while this Neosensory SDK has an Apache 2.0 license,
+ * usage of the Neosensory API to interface with Neosensory products is
+ * still  subject to the Neosensory developer terms of service located at:
+ * https://neosensory.com/legal/dev-terms-service/
+ *
+ * bounded_ram_test.cpp - Runs a long randomized session against a
+ * NeosensoryBluefruit built with NEO_BOUNDED_RAM and checks that it
+ * never allocates from the heap.
+ *
+ * Build and run with "make check" in this directory. Allocations are
+ * counted by wrapping glibc's malloc, so this test needs Linux.
+ */
+
+#include "neosensory_bluefruit.h"
+#include "mock_link.h"
+
+#if !NEO_BOUNDED_RAM
+#error "bounded_ram_test must be built with NEO_BOUNDED_RAM=1"
+#endif
+
+extern "C" void* __libc_malloc(size_t size);
+extern "C" void* __libc_calloc(size_t count, size_t size);
+extern "C" void* __libc_realloc(void* ptr, size_t size);
+
+static bool counting = false;
+static long allocations = 0;
+
+extern "C" void* malloc(size_t size) {
+	if (counting) allocations++;
+	return __libc_malloc(size);
+}
+
+extern "C" void* calloc(size_t count, size_t size) {
+	if (counting) allocations++;
+	return __libc_calloc(count, size);
+}
+
+extern "C" void* realloc(void* ptr, size_t size) {
+	if (counting) allocations++;
+	return __libc_realloc(ptr, size);
+}
+
+static const int kSessionOps = 500000;
+
+static NeosensoryBluefruit neo;
+static NeosensoryTrackReader track;
+static uint8_t track_data[NEO_TRACK_HEADER_SIZE + 200 * 5];
+static uint8_t calibration[NEO_CALIBRATION_HEADER_SIZE + NEO_MAX_MOTORS * NEO_CALIBRATION_MOTOR_SIZE];
+
+static float randomIntensity(void) {
+	return (rand() % 101) / 100.0f;
+}
+
+static void randomDeviceId(char device_id[]) {
+	snprintf(device_id, 18, "%02X %02X %02X %02X %02X %02X",
+		rand() % 4, rand() % 4, rand() % 4, 0xEA, 0x96, 0x31);
+}
+
+static void randomNotification(void) {
+	static const char* messages[] = {
+		"{\"button_val\": 1}", "{\"button_val\":3}", "{\"battery_soc\":87.5}",
+		"{\"message\":\"Developer API access granted!\"}", "motors vibrate ok\n{", "}{}",
+	};
+	const char* message = messages[rand() % 6];
+	size_t len = strlen(message);
+	size_t split = rand() % (len + 1);
+	neo.readNotifyCallback(NULL, (uint8_t*)message, split);
+	neo.readNotifyCallback(NULL, (uint8_t*)message + split, len - split);
+}
+
+static void randomScanReport(void) {
+	uint8_t data[31];
+	ble_gap_evt_adv_report_t report;
+	memset(&report, 0, sizeof(report));
+	report.data.p_data = data;
+	report.data.len = rand() % sizeof(data);
+	for (int i = 0; i < report.data.len; i++) {
+		data[i] = i >= 7 && i < 11 ? "Buzz"[i - 7] : rand();
+	}
+	for (int i = 0; i < BLE_GAP_ADDR_LEN; i++) {
+		report.peer_addr.addr[i] = rand() % 4;
+	}
+	neo.scanCallback(&report);
+}
+
+static void randomOperation(void) {
+	float frame[NEO_MAX_MOTORS];
+	float frames[8][NEO_MAX_MOTORS];
+	float* frame_pointers[8];
+	char device_id[18];
+	for (int i = 0; i < 8; i++) {
+		frame_pointers[i] = frames[i];
+		for (int j = 0; j < NEO_MAX_MOTORS; j++) {
+			frames[i][j] = randomIntensity();
+		}
+	}
+	for (int j = 0; j < NEO_MAX_MOTORS; j++) {
+		frame[j] = randomIntensity();
+	}
+	switch (rand() % 20) {
+		case 0: neo.vibrateMotors(frame); break;
+		case 1: neo.vibrateMotors(frame_pointers, rand() % 9); break;
+		case 2: neo.vibrateMotor(rand() % 4, randomIntensity()); break;
+		case 3: neo.setMotor(rand() % 4, randomIntensity()); break;
+		case 4: neo.playAlert(frame_pointers, rand() % 9, rand() % 3); break;
+		case 5: track.rewind(); neo.playTrack(&track); break;
+		case 6: neo.stopTrack(); break;
+		case 7: neo.setMotorRange(rand() % 4, rand() % 64, 128 + rand() % 128); break;
+		case 8: neo.saveCalibration(calibration, sizeof(calibration));
+			neo.loadCalibration(calibration, sizeof(calibration)); break;
+		case 9: randomDeviceId(device_id); neo.addDeviceId(device_id, rand() % 3); break;
+		case 10: randomDeviceId(device_id); neo.removeDeviceId(device_id); break;
+		case 11: randomScanReport(); break;
+		case 12: randomNotification(); break;
+		case 13: neo.setLatencyBudget(rand() % 2 ? 0 : rand() % 300); break;
+		case 14: neo.fadeLed(rand() % 3, rand() & 0xFFFFFF, rand() % 51, rand() % 500); break;
+		case 15: neo.followMotorLed(rand() % 3, rand() & 0xFFFFFF, rand() % 4, 50); break;
+		case 16: {
+			char* colors[] = {(char*)"0xFF0000", (char*)"0x00FF00", (char*)"0x0000FF"};
+			int intensities[] = {rand() % 51, rand() % 51, rand() % 51};
+			neo.setLeds(colors, intensities);
+			break;
+		}
+		case 17: neo.disconnectCallback(1, 0x13); neo.connectCallback(1); break;
+		case 18: neo.getLinkStats(); neo.getSparseStats(); neo.canAccept(rand() % 64); break;
+		default: neo.flushMotors(); break;
+	}
+	mock_millis += rand() % 20;
+	neo.update();
+}
+
+/** @brief Prints the RAM figure documented in neosensory_bluefruit_config.h. */
+static void printRamFigure(void) {
+	printf("NeosensoryBluefruit uses %zu bytes, of which NeoBoundedStorage is %zu\n",
+		(size_t)NEO_BOUNDED_RAM_BYTES, sizeof(NeoBoundedStorage));
+}
+
+int main(void) {
+	printRamFigure();
+	srand(1);
+	uint8_t motor_frames[200 * NEO_MAX_MOTORS];
+	for (size_t i = 0; i < sizeof(motor_frames); i++) {
+		motor_frames[i] = (i / 40) % 2 ? 200 : 0;
+	}
+	size_t track_len = neoEncodeTrack(motor_frames, 200, NEO_MAX_MOTORS, 16,
+		track_data, sizeof(track_data));
+	if (!track.open(track_data, track_len)) {
+		fprintf(stderr, "FAIL: could not encode the test track\n");
+		return 1;
+	}
+	mock_record_writes = false;
+	neo.connectCallback(1);
+
+	counting = true;
+	for (int i = 0; i < kSessionOps; i++) {
+		randomOperation();
+	}
+	counting = false;
+
+	printf("%d operations, %zu writes, %zu bytes: %ld heap allocations\n",
+		kSessionOps, mock_write_count, mock_write_bytes, allocations);
+	if (allocations != 0) {
+		fprintf(stderr, "FAIL: NEO_BOUNDED_RAM build allocated from the heap\n");
+		return 1;
+	}
+	printf("PASS bounded_ram_test\n");
+	return 0;
+}
@@ -0,0 +1,126 @@
+/*
+ * Copyright 2020 Neosensory, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Please note that while this Neosensory SDK has an Apache 2.0 license,
+ * usage of the Neosensory API to interface with Neosensory products is
+ * still  subject to the Neosensory developer terms of service located at:
+ * https://neosensory.com/legal/dev-terms-service/
+ *
+ * button_gestures_test.cpp - Checks the button gestures decoded from
+ * sequences of wristband reports, and that a long press is published from
+ * update() when it is long enough rather than on a later report.
+ *
+ * Built with NEO_BUTTON_REPORTS_REPEAT=1, so long presses are published.
+ */
+
+#include <vector>
+#include "neosensory_bluefruit.h"
+#include "test_util.h"
+
+#if !NEO_BUTTON_REPORTS_REPEAT
+#error "button_gestures_test must be built with NEO_BUTTON_REPORTS_REPEAT=1"
+#endif
+
+static const uint32_t kRepeatMs = 100; // Below NEO_BUTTON_DEBOUNCE_MS
+
+static NeosensoryBluefruit neo;
+static std::vector<NeoButtonGesture> gestures;
+static std::vector<uint32_t> gesture_times;
+static void onButton(const NeoEvent& event, void* context) {
+	gestures.push_back(event.button.gesture);
+	gesture_times.push_back(event.time_ms);
+}
+
+static void reportButton(uint8_t button) {
+	char message[32];
+	int len = snprintf(message, sizeof(message), "{\"button_val\":%u}", button);
+	neo.readNotifyCallback(NULL, (uint8_t*)message, len);
+}
+
+/** @brief Clears recorded gestures and lets any press in progress end */
+static void settle(void) {
+	runFor(neo, NEO_BUTTON_LONG_PRESS_MS * 2);
+	gestures.clear();
+	gesture_times.clear();
+}
+
+static void testSinglePress(void) {
+	settle();
+	reportButton(1);
+	runFor(neo, NEO_BUTTON_LONG_PRESS_MS * 2);
+	expect(gestures.size() == 1 && gestures[0] == NEO_BUTTON_PRESS,
+		"a single report is one press, never a long press");
+}
+
+static void testDoublePress(void) {
+	settle();
+	reportButton(1);
+	runFor(neo, NEO_BUTTON_DEBOUNCE_MS + 50);
+	reportButton(1);
+	runFor(neo, NEO_BUTTON_LONG_PRESS_MS * 2);
+	expect(gestures.size() == 3 && gestures[1] == NEO_BUTTON_PRESS &&
+		gestures[2] == NEO_BUTTON_DOUBLE_PRESS, "two quick presses are a double press");
+}
+
+static void testBounce(void) {
+	settle();
+	reportButton(1);
+	runFor(neo, NEO_BUTTON_DEBOUNCE_MS / 3);
+	reportButton(1);
+	runFor(neo, NEO_BUTTON_LONG_PRESS_MS * 2);
+	expect(gestures.size() == 1, "a bounce within the debounce time is ignored");
+}
+
+/** @brief Holds a button with repeated reports until well past the long
+ *	press time, and checks the long press is published at the threshold
+ */
+static void testLongPressAtThreshold(void) {
+	settle();
+	uint32_t start = mock_millis;
+	reportButton(2);
+	while (mock_millis - start < NEO_BUTTON_LONG_PRESS_MS * 2) {
+		runFor(neo, kRepeatMs);
+		reportButton(2);
+	}
+	runFor(neo, NEO_BUTTON_LONG_PRESS_MS);
+	expect(gestures.size() == 2 && gestures[0] == NEO_BUTTON_PRESS &&
+		gestures[1] == NEO_BUTTON_LONG_PRESS, "a held button is one press and one long press");
+	if (gestures.size() == 2) {
+		uint32_t delay = gesture_times[1] - start;
+		printf("long press published %u ms after the press started\n", delay);
+		expect(delay == NEO_BUTTON_LONG_PRESS_MS, "long press is published at the threshold");
+	}
+}
+
+/** @brief Stops reporting before the long press time, so the press ended */
+static void testReleasedBeforeLongPress(void) {
+	settle();
+	reportButton(3);
+	runFor(neo, kRepeatMs);
+	reportButton(3);
+	runFor(neo, NEO_BUTTON_LONG_PRESS_MS * 2);
+	expect(gestures.size() == 1, "a press released early is not a long press");
+}
+
+int main(void) {
+	neo.connectCallback(1);
+	neo.subscribe(NEO_EVENT_BUTTON, onButton);
+	testSinglePress();
+	testDoublePress();
+	testBounce();
+	testLongPressAtThreshold();
+	testReleasedBeforeLongPress();
+	return testResult("button_gestures_test");
+}
@@ -0,0 +1,86 @@
+/*
+ * Copyright 2020 Neosensory, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Please note that while this Neosensory SDK has an Apache 2.0 license,
+ * usage of the Neosensory API to interface with Neosensory products is
+ * still  subject to the Neosensory developer terms of service located at:
+ * https://neosensory.com/legal/dev-terms-service/
+ *
+ * event_bus_bench.cpp - Measures NeosensoryEventBus::publish() as handlers
+ * are subscribed to the published type and to other types, and prints the
+ * RAM the bus and the button decoder take.
+ *
+ * Built with NEO_MAX_SUBSCRIBERS=16 to sweep past the default of 4.
+ */
+
+#include <chrono>
+#include <stdio.h>
+#include "neosensory_event_bus.h"
+
+static const int kEvents = 2000000;
+
+static volatile uint32_t handled = 0;
+
+static void countEvent(const NeoEvent& event, void* context) {
+	handled = handled + 1;
+}
+
+/** @brief Publishes kEvents button events and returns nanoseconds per publish */
+static double timePublish(NeosensoryEventBus& bus) {
+	NeoEvent event;
+	event.type = NEO_EVENT_BUTTON;
+	event.time_ms = 0;
+	event.button.button = 0;
+	event.button.gesture = NEO_BUTTON_PRESS;
+	auto start = std::chrono::steady_clock::now();
+	for (int i = 0; i < kEvents; i++) {
+		event.time_ms = i;
+		bus.publish(event);
+	}
+	double seconds = std::chrono::duration<double>(
+		std::chrono::steady_clock::now() - start).count();
+	return seconds * 1e9 / kEvents;
+}
+
+int main(void) {
+	static int contexts[NEO_MAX_SUBSCRIBERS];
+	printf("sizeof(NeosensoryEventBus) = %zu bytes, sizeof(NeosensoryButtonGestures) = %zu bytes\n",
+		sizeof(NeosensoryEventBus), sizeof(NeosensoryButtonGestures));
+	printf("%d publishes of NEO_EVENT_BUTTON per row\n", kEvents);
+	printf("%14s %14s %12s %14s\n", "button subs", "other subs", "ns/publish", "ns/handler");
+	for (int other = 0; other <= NEO_MAX_SUBSCRIBERS; other += NEO_MAX_SUBSCRIBERS) {
+		for (int subs = 0; subs <= NEO_MAX_SUBSCRIBERS; subs = subs == 0 ? 1 : subs * 2) {
+			NeosensoryEventBus bus;
+			for (int i = 0; i < subs; i++) {
+				bus.subscribe(NEO_EVENT_BUTTON, countEvent, &contexts[i]);
+			}
+			// Handlers of every other type, which publishing a button event must not visit
+			for (int type = 0; type < NEO_EVENT_TYPE_COUNT; type++) {
+				for (int i = 0; type != NEO_EVENT_BUTTON && i < other; i++) {
+					bus.subscribe((NeoEventType)type, countEvent, &contexts[i]);
+				}
+			}
+			handled = 0;
+			double ns = timePublish(bus);
+			if (handled != (uint32_t)subs * kEvents) {
+				printf("FAIL: %u handler calls, expected %u\n", handled, (uint32_t)subs * kEvents);
+				return 1;
+			}
+			printf("%14d %14d %12.2f %14.2f\n", subs, other * (NEO_EVENT_TYPE_COUNT - 1),
+				ns, subs > 0 ? ns / subs : 0.0);
+		}
+	}
+	return 0;
+}
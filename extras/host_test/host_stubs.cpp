@@ -0,0 +1,115 @@
+/*
+ * Copyright 2020 Neosensory, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Please note that while this Neosensory SDK has an Apache 2.0 license,
+ * usage of the Neosensory API to interface with Neosensory products is
+ * still  subject to the Neosensory developer terms of service located at:
+ * https://neosensory.com/legal/dev-terms-service/
+ *
+ * host_stubs.cpp - Implementation of the host stubs and mock link.
+ */
+
+#include "Arduino.h"
+#include "Base64.h"
+#include "bluefruit.h"
+#include "mock_link.h"
+
+uint32_t mock_millis = 0;
+bool mock_record_writes = true;
+std::vector<std::string> mock_writes;
+size_t mock_write_count = 0;
+size_t mock_write_bytes = 0;
+size_t mock_connects = 0;
+uint8_t mock_connect_address[6];
+size_t mock_scan_resumes = 0;
+uint16_t mock_conn_interval = 0;
+
+AdafruitBluefruit Bluefruit;
+static BLEConnection connection;
+
+void mockResetLink(void) {
+	mock_writes.clear();
+	mock_write_count = 0;
+	mock_write_bytes = 0;
+	mock_connects = 0;
+	mock_scan_resumes = 0;
+	mock_conn_interval = 0;
+}
+
+uint32_t millis(void) {
+	return mock_millis;
+}
+
+void delay(uint32_t ms) {
+	mock_millis += ms;
+}
+
+void yield(void) {
+}
+
+uint16_t BLEClientCharacteristic::write(const void* data, uint16_t len) {
+	mock_write_count++;
+	mock_write_bytes += len;
+	if (mock_record_writes) {
+		mock_writes.push_back(std::string((const char*)data, len));
+	}
+	return len;
+}
+
+bool BLEConnection::requestConnectionParameter(
+	uint16_t conn_interval, uint16_t slave_latency, uint16_t sup_timeout) {
+	mock_conn_interval = conn_interval;
+	return true;
+}
+
+BLEConnection* AdafruitBluefruit::Connection(uint16_t conn_handle) {
+	return &connection;
+}
+
+bool BLECentral::connect(const ble_gap_evt_adv_report_t* report) {
+	return connect(&report->peer_addr);
+}
+
+bool BLECentral::connect(const ble_gap_addr_t* address) {
+	mock_connects++;
+	memcpy(mock_connect_address, address->addr, BLE_GAP_ADDR_LEN);
+	return true;
+}
+
+void BLEScanner::resume(void) {
+	mock_scan_resumes++;
+}
+
+static const char base64_alphabet[] =
+	"ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+int base64_enc_len(int plainLen) {
+	return (plainLen + 2) / 3 * 4;
+}
+
+int base64_encode(char* output, char* input, int inputLen) {
+	int o = 0;
+	for (int i = 0; i < inputLen; i += 3) {
+		uint32_t v = (uint32_t)(uint8_t)input[i] << 16;
+		if (i + 1 < inputLen) v |= (uint32_t)(uint8_t)input[i + 1] << 8;
+		if (i + 2 < inputLen) v |= (uint8_t)input[i + 2];
+		output[o++] = base64_alphabet[(v >> 18) & 63];
+		output[o++] = base64_alphabet[(v >> 12) & 63];
+		output[o++] = i + 1 < inputLen ? base64_alphabet[(v >> 6) & 63] : '=';
+		output[o++] = i + 2 < inputLen ? base64_alphabet[v & 63] : '=';
+	}
+	output[o] = '\0';
+	return o;
+}
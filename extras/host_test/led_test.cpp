@@ -0,0 +1,164 @@
+/*
+ * Copyright 2020 Neosensory, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Please note that while this Neosensory SDK has an Apache 2.0 license,
+ * usage of the Neosensory API to interface with Neosensory products is
+ * still  subject to the Neosensory developer terms of service located at:
+ * https://neosensory.com/legal/dev-terms-service/
+ *
+ * led_test.cpp - Checks the LED states NeosensoryBluefruit sends for
+ * setLeds() and LED animations, including after a reconnect.
+ */
+
+#include "neosensory_bluefruit.h"
+#include "test_util.h"
+
+static NeosensoryBluefruit neo;
+/** @brief Returns the LED commands written since the link was reset */
+static std::vector<std::string> ledWrites(void) {
+	std::vector<std::string> leds;
+	for (const std::string& write : mock_writes) {
+		size_t at = write.find("leds set ");
+		if (at != std::string::npos) {
+			leds.push_back(write.substr(at));
+		}
+	}
+	return leds;
+}
+
+static void setLeds(const char* a, const char* b, const char* c, int x, int y, int z) {
+	char* colors[] = {(char*)a, (char*)b, (char*)c};
+	int intensities[] = {x, y, z};
+	neo.setLeds(colors, intensities);
+}
+
+/** @brief Animating one LED before any setLeds() turns the others off */
+static void testAnimationFromUnknownState(void) {
+	neo.connectCallback(1);
+	mockResetLink();
+	neo.fadeLed(0, 0x00FF00, 40, 0);
+	runFor(neo, 100);
+	std::vector<std::string> leds = ledWrites();
+	expect(leds.size() == 1 && leds[0] == "leds set 0x00FF00 0x000000 0x000000 40 0 0\n",
+		"LEDs never set are turned off");
+}
+
+/** @brief Animating one LED keeps the others as setLeds() left them */
+static void testAnimationKeepsOtherLeds(void) {
+	setLeds("0xFF0000", "0x00FF00", "0x0000FF", 10, 20, 30);
+	mockResetLink();
+	neo.fadeLed(1, 0xFFFFFF, 50, 0);
+	runFor(neo, 100);
+	std::vector<std::string> leds = ledWrites();
+	expect(leds.size() == 1 && leds[0] == "leds set 0xFF0000 0xFFFFFF 0x0000FF 10 50 30\n",
+		"an animation keeps the state of the other LEDs");
+	neo.stopLedAnimations();
+	mockResetLink();
+	runFor(neo, 500);
+	expect(ledWrites().empty(), "nothing is sent once animations stop");
+}
+
+/** @brief A static setLeds() state is sent again once after a reconnect */
+static void testStaticStateAfterReconnect(void) {
+	setLeds("0x112233", "0x445566", "0x778899", 5, 6, 7);
+	runFor(neo, 500);
+	neo.disconnectCallback(1, 0x13);
+	neo.connectCallback(1);
+	mockResetLink();
+	runFor(neo, 500);
+	std::vector<std::string> leds = ledWrites();
+	expect(leds.size() == 1 && leds[0] == "leds set 0x112233 0x445566 0x778899 5 6 7\n",
+		"setLeds() state is sent once after a reconnect");
+}
+
+/** @brief A stopped animation's last state is sent again after a reconnect */
+static void testStoppedAnimationAfterReconnect(void) {
+	neo.fadeLed(2, 0xABCDEF, 20, 0);
+	runFor(neo, 100);
+	neo.stopLedAnimations();
+	neo.disconnectCallback(1, 0x13);
+	neo.connectCallback(1);
+	mockResetLink();
+	runFor(neo, 500);
+	std::vector<std::string> leds = ledWrites();
+	expect(leds.size() == 1 && leds[0] == "leds set 0x112233 0x445566 0xABCDEF 5 6 20\n",
+		"a stopped animation's state is sent once after a reconnect");
+}
+
+/** @brief setLeds() and animations clamp intensities to the same limit */
+static void testIntensityLimit(void) {
+	mockResetLink();
+	setLeds("0x110000", "0x001100", "0x000011", 200, -5, NEO_LED_MAX_INTENSITY);
+	std::vector<std::string> leds = ledWrites();
+	expect(leds.size() == 1 && leds[0] == "leds set 0x110000 0x001100 0x000011 50 0 50\n",
+		"setLeds() clamps intensities to NEO_LED_MAX_INTENSITY");
+	mockResetLink();
+	neo.fadeLed(1, 0x001100, 200, 0);
+	runFor(neo, 100);
+	leds = ledWrites();
+	expect(leds.size() == 1 && leds[0] == "leds set 0x110000 0x001100 0x000011 50 50 50\n",
+		"animations clamp intensities to NEO_LED_MAX_INTENSITY");
+	neo.stopLedAnimations();
+}
+
+/** @brief Blinks an LED faster than LED updates may be sent, optionally
+ *	streaming motor frames to share writes with, and checks the time between
+ *	the writes that carry LED updates
+ */
+static void testWriteSpacing(bool stream) {
+	char what[96];
+	neo.blinkLed(0, 0xFFFFFF, 30, 20);
+	mockResetLink();
+	uint32_t last_write_ms = 0;
+	uint32_t least_gap_ms = UINT32_MAX;
+	size_t led_writes = 0;
+	float frame[4] = {0, 0, 0, 0};
+	for (uint32_t t = 0; t < 1000; t++) {
+		// Every write in this loop happens at the same mock_millis
+		size_t seen = mock_writes.size();
+		runFor(neo, 1);
+		if (stream && t % 16 == 0) {
+			frame[0] = frame[0] > 0 ? 0 : 0.5f;
+			neo.vibrateMotors(frame);
+		}
+		for (size_t i = seen; i < mock_writes.size(); i++) {
+			if (mock_writes[i].find("leds set ") == std::string::npos) {
+				continue;
+			}
+			if (led_writes > 0) {
+				least_gap_ms = min(least_gap_ms, mock_millis - last_write_ms);
+			}
+			last_write_ms = mock_millis;
+			led_writes++;
+		}
+	}
+	neo.stopLedAnimations();
+	printf("%s: %zu LED writes, at least %u ms apart\n",
+		stream ? "blink while streaming" : "blink", led_writes, least_gap_ms);
+	snprintf(what, sizeof(what), "LED writes %s are NEO_LED_MIN_INTERVAL_MS apart",
+		stream ? "sharing motor packets" : "on their own");
+	expect(led_writes > 10 && least_gap_ms >= NEO_LED_MIN_INTERVAL_MS, what);
+}
+
+int main(void) {
+	testAnimationFromUnknownState();
+	testAnimationKeepsOtherLeds();
+	testStaticStateAfterReconnect();
+	testStoppedAnimationAfterReconnect();
+	testIntensityLimit();
+	testWriteSpacing(false);
+	testWriteSpacing(true);
+	return testResult("led_test");
+}
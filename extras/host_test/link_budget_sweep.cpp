@@ -0,0 +1,115 @@
+/*
+ * Copyright 2020 Neosensory, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Please note that while this Neosensory SDK has an Apache 2.0 license,
+ * usage of the Neosensory API to interface with Neosensory products is
+ * still  subject to the Neosensory developer terms of service located at:
+ * https://neosensory.com/legal/dev-terms-service/
+ *
+ * link_budget_sweep.cpp - Streams single frames over the mock link at a
+ * range of latency budgets and prints getLinkStats() for each, with the
+ * longest a frame waited before it was written.
+ */
+
+#include <algorithm>
+#include "neosensory_bluefruit.h"
+#include "mock_link.h"
+
+static const int kMotors = 4;
+static const int kFrameMs = 16;
+static const uint32_t kRunMs = 10000;
+static const uint16_t kBudgets[] = {0, 16, 32, 64, 128, 200};
+
+static NeosensoryBluefruit neo;
+
+int main(void) {
+	mock_record_writes = false;
+	neo.connectCallback(1);
+	printf("Single frames every %d ms for %u s\n", kFrameMs, kRunMs / 1000);
+	printf("%8s %10s %7s %8s %8s %10s %10s %12s %12s\n", "budget", "interval", "writes",
+		"packets", "bytes", "radio us", "packets/s", "max wait ms", "link check");
+	bool consistent = true;
+	for (uint16_t budget : kBudgets) {
+		neo.setLatencyBudget(budget);
+		neo.motorsClearQueue();
+		neo.resetLinkStats();
+		uint16_t interval = mock_conn_interval;
+		mockResetLink();
+		uint32_t oldest_unsent_ms = 0;
+		bool has_unsent = false;
+		uint32_t max_wait_ms = 0;
+		size_t writes_seen = 0;
+		float frame[kMotors];
+		for (uint32_t t = 0; t < kRunMs; t++) {
+			if (t % kFrameMs == 0) {
+				for (int m = 0; m < kMotors; m++) {
+					frame[m] = ((t / kFrameMs + m * 3) % 10) / 10.0f;
+				}
+				neo.vibrateMotors(frame);
+				if (!has_unsent && mock_write_count == writes_seen) {
+					has_unsent = true;
+					oldest_unsent_ms = mock_millis;
+				}
+			}
+			neo.update();
+			if (mock_write_count != writes_seen) {
+				writes_seen = mock_write_count;
+				if (has_unsent) {
+					max_wait_ms = std::max(max_wait_ms, mock_millis - oldest_unsent_ms);
+					has_unsent = false;
+				}
+			}
+			mock_millis++;
+		}
+		NeoLinkStats stats = neo.getLinkStats();
+		// The stats must count exactly the writes the mock link received
+		bool matches = stats.writes == mock_write_count && stats.bytes == mock_write_bytes;
+		consistent = consistent && matches && max_wait_ms <= budget + kFrameMs;
+		printf("%6u ms %7.2f ms %7u %8u %8u %10u %10.1f %12u %12s\n", budget,
+			interval * 1.25f, stats.writes, stats.packets, stats.bytes,
+			stats.radio_on_us, stats.packets_per_second, max_wait_ms,
+			matches ? "ok" : "mismatch");
+	}
+	if (!consistent) {
+		printf("FAIL: link stats disagree with the mock link, or a frame waited past its budget\n");
+		return 1;
+	}
+
+	// A full packet of frames must go out as one write that fits one radio packet
+	neo.setLatencyBudget(0);
+	neo.motorsClearQueue();
+	mock_millis += 1000;
+	neo.update();
+	neo.resetLinkStats();
+	mockResetLink();
+	const int full = neo.max_frames_per_bt_package();
+	static float frames[255][kMotors];
+	float *rows[255];
+	for (int f = 0; f < full; f++) {
+		for (int m = 0; m < kMotors; m++) {
+			frames[f][m] = 1.0f;
+		}
+		rows[f] = frames[f];
+	}
+	neo.vibrateMotors(rows, full);
+	NeoLinkStats stats = neo.getLinkStats();
+	printf("Full packet: %d frames, %u writes, %u packets, %u bytes\n",
+		full, stats.writes, stats.packets, stats.bytes);
+	if (stats.writes != 1 || stats.packets != 1 || mock_write_bytes > 244) {
+		printf("FAIL: a full packet of frames did not fit in one radio packet\n");
+		return 1;
+	}
+	return 0;
+}
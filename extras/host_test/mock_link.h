@@ -0,0 +1,48 @@
+/*
+ * Copyright 2020 Neosensory, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Please note that while this Neosensory SDK has an Apache 2.0 license,
+ * usage of the Neosensory API to interface with Neosensory products is
+ * still  subject to the Neosensory developer terms of service located at:
+ * https://neosensory.com/legal/dev-terms-service/
+ *
+ * mock_link.h - Clock and Bluetooth link of the host stubs, which tests
+ * and benchmarks drive and inspect.
+ */
+
+#ifndef MockLink_h
+#define MockLink_h
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+extern uint32_t mock_millis; /**< Time millis() returns. Only changes when a test changes it. */
+
+extern bool mock_record_writes; /**< Keep a copy of each write in mock_writes. Defaults to true. */
+extern std::vector<std::string> mock_writes; /**< Writes to the wristband, if recorded. */
+extern size_t mock_write_count; /**< Writes to the wristband, always counted. */
+extern size_t mock_write_bytes; /**< Bytes written to the wristband, always counted. */
+
+extern size_t mock_connects; /**< Calls to Bluefruit.Central.connect(). */
+extern uint8_t mock_connect_address[6]; /**< Address passed to the last connect. */
+extern size_t mock_scan_resumes; /**< Calls to Bluefruit.Scanner.resume(). */
+extern uint16_t mock_conn_interval; /**< Last connection interval requested, in units of 1.25 ms. */
+
+/** @brief Clears the writes and counters of the mock link. */
+void mockResetLink(void);
+
+#endif
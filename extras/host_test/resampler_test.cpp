@@ -0,0 +1,212 @@
+/*
+ * Copyright 2020 Neosensory, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Please note that while this Neosensory SDK has an Apache 2.0 license,
+ * usage of the Neosensory API to interface with Neosensory products is
+ * still  subject to the Neosensory developer terms of service located at:
+ * https://neosensory.com/legal/dev-terms-service/
+ *
+ * resampler_test.cpp - Checks the accuracy of NeosensoryFrameResampler on
+ * known inputs and measures its throughput per block of frames.
+ */
+
+#include <chrono>
+#include <math.h>
+#include <stdio.h>
+#include "neosensory_frame_resampler.h"
+#include "test_util.h"
+
+static const int kChannels = 4;
+static const int kFrameMs = 16;
+static const int kBlockFrames = 42; // Frames in one Bluetooth packet for 4 motors
+static const float kTolerance = 1e-4f;
+
+/** @brief Value of channel c of a ramp at time t, distinct per channel */
+static float ramp(float t, int c) {
+	return t / 1000.0f + c * 0.1f;
+}
+
+/** @brief Pushes a ramp sampled at 100 Hz over 1 s and checks that every
+ *	frame equals the ramp at the frame's time. The average of a line over
+ *	a window centered on a point is the line's value there, so windowed
+ *	frames must be exact as well as linear ones.
+ */
+static void testRamp(NeoResampleMode mode, const char* name) {
+	NeosensoryFrameResampler resampler(kChannels, kFrameMs, mode);
+	float sample[kChannels];
+	float storage[kBlockFrames][kChannels];
+	float* frames[kBlockFrames];
+	for (int i = 0; i < kBlockFrames; i++) {
+		frames[i] = storage[i];
+	}
+	int num_frames = 0;
+	float max_error = 0;
+	for (uint32_t t = 0; t <= 1000; t += 10) {
+		for (int c = 0; c < kChannels; c++) {
+			sample[c] = ramp(t, c);
+		}
+		resampler.pushSample(t, sample);
+		size_t pulled = resampler.pullFrames(frames, kBlockFrames);
+		for (size_t i = 0; i < pulled; i++, num_frames++) {
+			// Windowed frames near the first sample see it held before its time
+			float frame_time = (float)num_frames * kFrameMs;
+			if (mode == NEO_RESAMPLE_WINDOWED && frame_time < kFrameMs / 2) {
+				continue;
+			}
+			for (int c = 0; c < kChannels; c++) {
+				max_error = fmaxf(max_error, fabsf(frames[i][c] - ramp(frame_time, c)));
+			}
+		}
+	}
+	int expected_frames = mode == NEO_RESAMPLE_WINDOWED ?
+		(1000 - kFrameMs / 2) / kFrameMs + 1 : 1000 / kFrameMs + 1;
+	printf("%-8s 100 Hz ramp: %d frames, max error %g\n", name, num_frames, max_error);
+	expect(num_frames == expected_frames, "ramp frame count");
+	expect(max_error < kTolerance, "ramp frames match the ramp");
+}
+
+/** @brief Pushes a 25 Hz step sequence over 1 s and checks that HOLD
+ *	renders one frame per 16 ms, each equal to the latest sample at or
+ *	before it.
+ */
+static void testHoldAt25Hz(void) {
+	NeosensoryFrameResampler resampler(kChannels, kFrameMs, NEO_RESAMPLE_HOLD);
+	float sample[kChannels];
+	float storage[kBlockFrames][kChannels];
+	float* frames[kBlockFrames];
+	for (int i = 0; i < kBlockFrames; i++) {
+		frames[i] = storage[i];
+	}
+	int num_frames = 0;
+	int mismatches = 0;
+	for (uint32_t t = 0; t <= 1000; t += 40) {
+		for (int c = 0; c < kChannels; c++) {
+			sample[c] = t + c;
+		}
+		resampler.pushSample(t, sample);
+		size_t pulled = resampler.pullFrames(frames, kBlockFrames);
+		for (size_t i = 0; i < pulled; i++, num_frames++) {
+			uint32_t held_time = num_frames * kFrameMs / 40 * 40;
+			for (int c = 0; c < kChannels; c++) {
+				if (frames[i][c] != held_time + c) {
+					mismatches++;
+				}
+			}
+		}
+	}
+	printf("HOLD     25 Hz steps: %d frames, %d mismatched values\n", num_frames, mismatches);
+	expect(num_frames == 1000 / kFrameMs + 1, "25 Hz hold frame count");
+	expect(mismatches == 0, "25 Hz hold frames equal the latest sample");
+}
+
+/** @brief Pushes steps up and down through HOLD with setMaxChangePerFrame()
+ *	and checks that each frame moves toward the step by at most the limit,
+ *	then that disabling the limit passes a step straight through.
+ */
+static void testMaxChangePerFrame(void) {
+	const float kMaxChange = 0.125f;
+	NeosensoryFrameResampler resampler(kChannels, kFrameMs, NEO_RESAMPLE_HOLD);
+	resampler.setMaxChangePerFrame(kMaxChange);
+	float sample[kChannels];
+	float storage[kBlockFrames][kChannels];
+	float* frames[kBlockFrames];
+	for (int i = 0; i < kBlockFrames; i++) {
+		frames[i] = storage[i];
+	}
+	// Channel c steps between 0 and 1 - c / 4 every 320 ms, i.e. 20 frames
+	int num_frames = 0;
+	int mismatches = 0;
+	float expected[kChannels] = {0, 0, 0, 0};
+	for (uint32_t t = 0; t <= 1280; t += 10) {
+		bool high = (t / 320) % 2 == 1;
+		for (int c = 0; c < kChannels; c++) {
+			sample[c] = high ? 1.0f - c / 4.0f : 0;
+		}
+		resampler.pushSample(t, sample);
+		size_t pulled = resampler.pullFrames(frames, kBlockFrames);
+		for (size_t i = 0; i < pulled; i++, num_frames++) {
+			bool frame_high = (num_frames * kFrameMs / 320) % 2 == 1;
+			for (int c = 0; c < kChannels; c++) {
+				float target = frame_high ? 1.0f - c / 4.0f : 0;
+				expected[c] = fmaxf(expected[c] - kMaxChange,
+					fminf(expected[c] + kMaxChange, target));
+				if (fabsf(frames[i][c] - expected[c]) > kTolerance) {
+					mismatches++;
+				}
+			}
+		}
+	}
+	printf("HOLD     max change %g: %d frames, %d mismatched values\n",
+		kMaxChange, num_frames, mismatches);
+	expect(num_frames == 1280 / kFrameMs + 1, "limited frame count");
+	expect(mismatches == 0, "frames change by at most the limit per frame");
+
+	resampler.setMaxChangePerFrame(0);
+	for (int c = 0; c < kChannels; c++) {
+		sample[c] = 1.0f;
+	}
+	resampler.pushSample(1300, sample);
+	resampler.pushSample(1400, sample);
+	size_t pulled = resampler.pullFrames(frames, kBlockFrames);
+	expect(pulled > 0 && frames[pulled - 1][0] == 1.0f, "a limit of 0 passes steps through");
+}
+
+/** @brief Measures the time to push 100 Hz samples and pull them into
+ *	blocks of frames.
+ */
+static void benchmarkBlocks(NeoResampleMode mode, const char* name) {
+	const int kBlocks = 20000;
+	NeosensoryFrameResampler resampler(kChannels, kFrameMs, mode);
+	float sample[kChannels];
+	float storage[kBlockFrames][kChannels];
+	float* frames[kBlockFrames];
+	for (int i = 0; i < kBlockFrames; i++) {
+		frames[i] = storage[i];
+	}
+	uint32_t t = 0;
+	size_t total_frames = 0;
+	float checksum = 0;
+	auto start = std::chrono::steady_clock::now();
+	for (int block = 0; block < kBlocks; block++) {
+		// The history spans less than a block, so pull as samples arrive
+		size_t filled = 0;
+		while (filled < (size_t)kBlockFrames) {
+			for (int c = 0; c < kChannels; c++) {
+				sample[c] = (float)((t * 7 + c * 13) % 100) / 100.0f;
+			}
+			resampler.pushSample(t, sample);
+			t += 10;
+			filled += resampler.pullFrames(frames + filled, kBlockFrames - filled);
+		}
+		total_frames += filled;
+		checksum += frames[0][0];
+	}
+	double seconds = std::chrono::duration<double>(
+		std::chrono::steady_clock::now() - start).count();
+	printf("%-8s throughput: %.2f us per %d-frame block, %.0f ns per frame (checksum %g)\n",
+		name, seconds * 1e6 / total_frames * kBlockFrames, kBlockFrames,
+		seconds * 1e9 / total_frames, checksum);
+}
+
+int main(void) {
+	testRamp(NEO_RESAMPLE_LINEAR, "LINEAR");
+	testRamp(NEO_RESAMPLE_WINDOWED, "WINDOWED");
+	testHoldAt25Hz();
+	testMaxChangePerFrame();
+	benchmarkBlocks(NEO_RESAMPLE_HOLD, "HOLD");
+	benchmarkBlocks(NEO_RESAMPLE_LINEAR, "LINEAR");
+	benchmarkBlocks(NEO_RESAMPLE_WINDOWED, "WINDOWED");
+	return testResult("resampler_test");
+}
@@ -0,0 +1,165 @@
+/*
+ * Copyright 2020 Neosensory, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Please note that while this Neosensory SDK has an Apache 2.0 license,
+ * usage of the Neosensory API to interface with Neosensory products is
+ * still  subject to the Neosensory developer terms of service located at:
+ * https://neosensory.com/legal/dev-terms-service/
+ *
+ * scan_bench.cpp - Measures NeosensoryBluefruit::scanCallback() as the
+ * device list grows to hundreds of devices, against a linear search of
+ * the same list, and checks lookups stay correct while devices are removed.
+ *
+ * Built with NEO_ADDRESS_SET_CAPACITY=1024, which holds up to 768 devices.
+ */
+
+#include <chrono>
+#include "neosensory_bluefruit.h"
+#include "mock_link.h"
+
+static const int kListSizes[] = {0, 1, 10, 50, 100, 200, 400, 700};
+static const int kReports = 200000;
+
+static NeosensoryBluefruit neo;
+
+/** @brief Formats the band name device id of device i, as "XX XX XX XX XX XX" */
+static void deviceId(int i, char device_id[18]) {
+	snprintf(device_id, 18, "%02X %02X %02X %02X %02X %02X",
+		0xEB, 0x31, (i >> 16) & 0xFF, (i >> 8) & 0xFF, i & 0xFF, 0x96);
+}
+
+/** @brief Fills a scan report from a Buzz named device i, in report byte order */
+static void fillReport(int i, ble_gap_evt_adv_report_t* report, uint8_t data[31]) {
+	static const uint8_t advertising[] = {
+		2, 1, 6, 3, 3, 0x9E, 0xCA, 5, 9, 'B', 'u', 'z', 'z'};
+	memset(report, 0, sizeof(*report));
+	memcpy(data, advertising, sizeof(advertising));
+	report->data.p_data = data;
+	report->data.len = sizeof(advertising);
+	const uint8_t address[] = {0xEB, 0x31, (uint8_t)(i >> 16), (uint8_t)(i >> 8), (uint8_t)i, 0x96};
+	for (int b = 0; b < BLE_GAP_ADDR_LEN; b++) {
+		report->peer_addr.addr[BLE_GAP_ADDR_LEN - (b + 1)] = address[b];
+	}
+}
+
+/** @brief Times scanCallback() on reports alternating between listed and
+ *	unlisted devices, and returns nanoseconds per report
+ */
+static double timeScanCallback(int list_size, size_t* connects) {
+	static ble_gap_evt_adv_report_t reports[64];
+	static uint8_t data[64][31];
+	for (int r = 0; r < 64; r++) {
+		int listed = list_size > 0 ? (r * 37) % list_size : 0;
+		fillReport(r % 2 == 0 ? listed : 100000 + r, &reports[r], data[r]);
+	}
+	mockResetLink();
+	auto start = std::chrono::steady_clock::now();
+	for (int i = 0; i < kReports; i++) {
+		neo.scanCallback(&reports[i & 63]);
+	}
+	double seconds = std::chrono::duration<double>(
+		std::chrono::steady_clock::now() - start).count();
+	*connects = mock_connects;
+	return seconds * 1e9 / kReports;
+}
+
+/** @brief Times a linear search of a list of list_size addresses, the
+ *	lookup the device list replaced, and returns nanoseconds per lookup
+ */
+static double timeLinearSearch(int list_size) {
+	static uint8_t addresses[1024][BLE_GAP_ADDR_LEN];
+	ble_gap_evt_adv_report_t report;
+	uint8_t data[31];
+	for (int i = 0; i < list_size; i++) {
+		fillReport(i, &report, data);
+		memcpy(addresses[i], report.peer_addr.addr, BLE_GAP_ADDR_LEN);
+	}
+	size_t found = 0;
+	auto start = std::chrono::steady_clock::now();
+	for (int i = 0; i < kReports; i++) {
+		fillReport(i % 2 == 0 && list_size > 0 ? (i * 37) % list_size : 100000 + i % 64, &report, data);
+		for (int j = 0; j < list_size; j++) {
+			if (memcmp(addresses[j], report.peer_addr.addr, BLE_GAP_ADDR_LEN) == 0) {
+				found++;
+				break;
+			}
+		}
+	}
+	double seconds = std::chrono::duration<double>(
+		std::chrono::steady_clock::now() - start).count();
+	if (found == 0 && list_size > 0) {
+		printf("linear search found nothing\n");
+	}
+	return seconds * 1e9 / kReports;
+}
+
+/** @brief Removes every third device and checks each device is found by a
+ *	DENY mode scan exactly when it is still listed
+ */
+static bool checkRemovals(int list_size) {
+	char device_id[18];
+	ble_gap_evt_adv_report_t report;
+	uint8_t data[31];
+	for (int i = 0; i < list_size; i += 3) {
+		deviceId(i, device_id);
+		neo.removeDeviceId(device_id);
+	}
+	for (int i = 0; i < list_size; i++) {
+		fillReport(i, &report, data);
+		mockResetLink();
+		neo.scanCallback(&report);
+		bool connected = mock_connects > 0;
+		if (connected != (i % 3 == 0)) {
+			printf("FAIL: device %d %s after removals\n", i, connected ? "connected" : "denied");
+			return false;
+		}
+	}
+	return true;
+}
+
+int main(void) {
+	char device_id[18];
+	printf("%10s %18s %18s %14s\n", "devices", "allow ns/report", "deny ns/report", "linear ns");
+	for (size_t s = 0; s < sizeof(kListSizes) / sizeof(kListSizes[0]); s++) {
+		int list_size = kListSizes[s];
+		neo.clearDeviceIds();
+		for (int i = 0; i < list_size; i++) {
+			deviceId(i, device_id);
+			if (!neo.addDeviceId(device_id)) {
+				printf("FAIL: could not add device %d\n", i);
+				return 1;
+			}
+		}
+		size_t allow_connects, deny_connects;
+		neo.setDeviceListMode(NEO_DEVICE_LIST_ALLOW);
+		double allow_ns = timeScanCallback(list_size, &allow_connects);
+		neo.setDeviceListMode(NEO_DEVICE_LIST_DENY);
+		double deny_ns = timeScanCallback(list_size, &deny_connects);
+		double linear_ns = timeLinearSearch(list_size);
+		printf("%10d %18.1f %18.1f %14.1f\n", list_size, allow_ns, deny_ns, linear_ns);
+		// Half the reports are listed, so half connect in either mode.
+		// An empty list connects to every Buzz in either mode.
+		size_t expected = list_size > 0 ? kReports / 2 : kReports;
+		if (allow_connects != expected || deny_connects != expected) {
+			printf("FAIL: %zu allow and %zu deny connects, expected %zu\n",
+				allow_connects, deny_connects, expected);
+			return 1;
+		}
+		if (!checkRemovals(list_size)) {
+			return 1;
+		}
+	}
+	return 0;
+}
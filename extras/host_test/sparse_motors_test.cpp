@@ -0,0 +1,104 @@
+/*
+ * Copyright 2020 Neosensory, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Please note that while this Neosensory SDK has an Apache 2.0 license,
+ * usage of the Neosensory API to interface with Neosensory products is
+ * still  subject to the Neosensory developer terms of service located at:
+ * https://neosensory.com/legal/dev-terms-service/
+ *
+ *
+ * sparse_motors_test.cpp - Checks that setMotor() updates are merged into
+ * one frame per firmware frame, and that getSparseStats() counts the
+ * packets actually sent, with and without a latency budget.
+ */
+
+#include "neosensory_bluefruit.h"
+#include "test_util.h"
+
+static const int kFrameMs = 16;
+
+static NeosensoryBluefruit neo;
+
+/** @brief Clears the queue, the counters and the mock link */
+static void reset(uint16_t latency_budget_ms) {
+	neo.setLatencyBudget(latency_budget_ms);
+	neo.motorsClearQueue();
+	runFor(neo, 1000);
+	neo.resetSparseStats();
+	mockResetLink();
+}
+
+/** @brief Updates merged into one frame go out as one packet */
+static void testMerge(void) {
+	reset(0);
+	neo.setMotor(0, 0.5f);
+	neo.setMotor(1, 0.5f);
+	neo.setMotor(3, 1.0f);
+	runFor(neo, kFrameMs);
+	NeoSparseStats stats = neo.getSparseStats();
+	expect(mock_write_count == 1, "merged updates are sent in one write");
+	expect(stats.updates == 3 && stats.flushes == 1 && stats.last_merged == 3,
+		"three updates are merged into one flushed frame");
+	expect(stats.packets == 1, "the flushed frame is counted as one packet");
+}
+
+/** @brief A flush that repeats the last frame sent is not counted as a packet */
+static void testRepeat(void) {
+	reset(0);
+	neo.setMotor(2, 0.7f);
+	neo.flushMotors();
+	neo.setMotor(2, 0.7f);
+	neo.flushMotors();
+	NeoSparseStats stats = neo.getSparseStats();
+	expect(mock_write_count == 1, "a repeated frame is not sent");
+	expect(stats.flushes == 2 && stats.packets == 1,
+		"a repeated frame is flushed but not counted as a packet");
+}
+
+/** @brief Under a latency budget, flushed frames share packets, and each packet is counted once */
+static void testBudget(void) {
+	reset(64);
+	for (int i = 0; i < 40; i++) {
+		neo.setMotor(i % 4, (i % 5) / 4.0f);
+		runFor(neo, kFrameMs);
+	}
+	runFor(neo, 200);
+	NeoSparseStats stats = neo.getSparseStats();
+	printf("budget 64 ms: %u flushes in %u packets, %zu writes\n",
+		stats.flushes, stats.packets, mock_write_count);
+	expect(stats.packets == mock_write_count, "packets match the writes sent");
+	expect(stats.packets < stats.flushes, "flushed frames share packets");
+}
+
+/** @brief A full frame replaces pending updates instead of flushing them */
+static void testFullFrame(void) {
+	reset(0);
+	neo.setMotor(0, 1.0f);
+	float frame[4] = {0.2f, 0.2f, 0.2f, 0.2f};
+	neo.vibrateMotors(frame);
+	runFor(neo, kFrameMs);
+	NeoSparseStats stats = neo.getSparseStats();
+	expect(mock_write_count == 1, "only the full frame is sent");
+	expect(stats.flushes == 0 && stats.packets == 0, "replaced updates are not flushed");
+}
+
+int main(void) {
+	neo.connectCallback(1);
+	testMerge();
+	testRepeat();
+	testBudget();
+	testFullFrame();
+	return testResult("sparse_motors_test");
+}
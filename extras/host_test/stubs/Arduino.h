@@ -0,0 +1,54 @@
+/*
+ * Copyright 2020 Neosensory, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Please note that while this Neosensory SDK has an Apache 2.0 license,
+ * usage of the Neosensory API to interface with Neosensory products is
+ * still  subject to the Neosensory developer terms of service located at:
+ * https://neosensory.com/legal/dev-terms-service/
+ *
+ * Arduino.h - Minimal stand-in for the Arduino core, so the library
+ * builds on a host for the tests and benchmarks in extras/host_test.
+ */
+
+#ifndef Arduino_h
+#define Arduino_h
+
+#include <math.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* As in ArduinoCore-API: by reference, so the result never refers to a copy */
+template<class A, class B> auto min(const A& a, const B& b) -> decltype(b < a ? b : a) {
+	return b < a ? b : a;
+}
+template<class A, class B> auto max(const A& a, const B& b) -> decltype(a < b ? b : a) {
+	return a < b ? b : a;
+}
+template<class T, class L, class H> T constrain(T x, L low, H high) {
+	return x < low ? low : (x > high ? high : x);
+}
+
+uint32_t millis(void);
+void delay(uint32_t ms);
+void yield(void);
+
+/* FreeRTOS critical sections. The host tests are single threaded. */
+#define taskENTER_CRITICAL()
+#define taskEXIT_CRITICAL()
+
+#endif
@@ -0,0 +1,34 @@
+/*
+ * Copyright 2020 Neosensory, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Please note that while this Neosensory SDK has an Apache 2.0 license,
+ * usage of the Neosensory API to interface with Neosensory products is
+ * still  subject to the Neosensory developer terms of service located at:
+ * https://neosensory.com/legal/dev-terms-service/
+ *
+ * Base64.h - Stand-in for the Arduino Base64 library, with the same
+ * functions and buffer size contract.
+ */
+
+#ifndef Base64_h
+#define Base64_h
+
+/** @brief Length of the encoding of plainLen bytes, not counting the terminating NUL. */
+int base64_enc_len(int plainLen);
+
+/** @brief Encodes inputLen bytes of input into output, followed by a NUL. */
+int base64_encode(char* output, char* input, int inputLen);
+
+#endif
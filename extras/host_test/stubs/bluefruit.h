@@ -0,0 +1,107 @@
+/*
+ * Copyright 2020 Neosensory, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Please note that while this Neosensory SDK has an Apache 2.0 license,
+ * usage of the Neosensory API to interface with Neosensory products is
+ * still  subject to the Neosensory developer terms of service located at:
+ * https://neosensory.com/legal/dev-terms-service/
+ *
+ * bluefruit.h - Stand-in for the parts of Adafruit's Bluefruit library the
+ * NeosensoryBluefruit library uses. Writes go to the mock link declared in
+ * mock_link.h instead of a radio.
+ */
+
+#ifndef Bluefruit_h
+#define Bluefruit_h
+
+#include "Arduino.h"
+
+#define BLE_GAP_ADDR_LEN 6
+#define BLE_CONN_HANDLE_INVALID 0xFFFF
+
+struct ble_gap_addr_t {
+	uint8_t addr_id_peer : 1;
+	uint8_t addr_type : 7;
+	uint8_t addr[BLE_GAP_ADDR_LEN];
+};
+
+struct ble_data_t {
+	uint8_t* p_data;
+	uint16_t len;
+};
+
+struct ble_gap_evt_adv_report_t {
+	ble_gap_addr_t peer_addr;
+	int8_t rssi;
+	ble_data_t data;
+};
+
+class BLEClientCharacteristic;
+typedef void (*notify_cb_t)(BLEClientCharacteristic*, uint8_t*, uint16_t);
+
+class BLEClientService {
+  public:
+	BLEClientService(const uint8_t* uuid) {}
+	bool begin(void) { return true; }
+	bool discover(uint16_t conn_handle) { return true; }
+};
+
+class BLEClientCharacteristic {
+  public:
+	BLEClientCharacteristic(const uint8_t* uuid) {}
+	bool begin(void) { return true; }
+	bool discover(void) { return true; }
+	bool enableNotify(void) { return true; }
+	void setNotifyCallback(notify_cb_t callback) {}
+	uint16_t write(const void* data, uint16_t len);
+};
+
+class BLEConnection {
+  public:
+	bool bonded(void) { return true; }
+	bool requestPairing(void) { return true; }
+	bool requestConnectionParameter(uint16_t conn_interval,
+		uint16_t slave_latency = 0, uint16_t sup_timeout = 400);
+};
+
+struct BLECentral {
+	void setConnectCallback(void (*callback)(uint16_t)) {}
+	void setDisconnectCallback(void (*callback)(uint16_t, uint8_t)) {}
+	bool connected(void) { return true; }
+	bool connect(const ble_gap_evt_adv_report_t* report);
+	bool connect(const ble_gap_addr_t* address);
+};
+
+struct BLEScanner {
+	void setRxCallback(void (*callback)(ble_gap_evt_adv_report_t*)) {}
+	void restartOnDisconnect(bool enable) {}
+	void setInterval(uint16_t interval, uint16_t window) {}
+	void useActiveScan(bool enable) {}
+	bool start(uint16_t timeout) { return true; }
+	void resume(void);
+};
+
+struct AdafruitBluefruit {
+	bool begin(int prph_count, int central_count) { return true; }
+	void setName(const char* name) {}
+	BLEConnection* Connection(uint16_t conn_handle);
+	bool disconnect(uint16_t conn_handle) { return true; }
+	BLECentral Central;
+	BLEScanner Scanner;
+};
+
+extern AdafruitBluefruit Bluefruit;
+
+#endif
@@ -0,0 +1,59 @@
+/*
+ * Copyright 2020 Neosensory, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Please note that while this Neosensory SDK has an Apache 2.0 license,
+ * usage of the Neosensory API to interface with Neosensory products is
+ * still  subject to the Neosensory developer terms of service located at:
+ * https://neosensory.com/legal/dev-terms-service/
+ *
+ * test_util.h - Checks and clock helpers shared by the host tests.
+ */
+
+#ifndef TestUtil_h
+#define TestUtil_h
+
+#include <stdint.h>
+#include <stdio.h>
+#include "mock_link.h"
+
+static int test_failures = 0;
+
+/** @brief Records a failure, with what was expected, if condition is false */
+static inline void expect(bool condition, const char* what) {
+	if (!condition) {
+		fprintf(stderr, "FAIL: %s\n", what);
+		test_failures++;
+	}
+}
+
+/** @brief Advances the mock clock by ms, calling device.update() every millisecond */
+template<class Device> void runFor(Device& device, uint32_t ms) {
+	for (uint32_t i = 0; i < ms; i++) {
+		mock_millis++;
+		device.update();
+	}
+}
+
+/** @brief Prints the result of a test program and returns its exit status */
+static inline int testResult(const char* name) {
+	if (test_failures > 0) {
+		fprintf(stderr, "%d checks failed in %s\n", test_failures, name);
+		return 1;
+	}
+	printf("PASS %s\n", name);
+	return 0;
+}
+
+#endif
@@ -0,0 +1,74 @@
+/*
+ * Copyright 2020 Neosensory, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Please note that while this Neosensory SDK has an Apache 2.0 license,
+ * usage of the Neosensory API to interface with Neosensory products is
+ * still  subject to the Neosensory developer terms of service located at:
+ * https://neosensory.com/legal/dev-terms-service/
+ *
+ * track_test.cpp - Checks that playTrack() streams a whole track within
+ * the device queue cap, including caps smaller than half a packet.
+ */
+
+#include "neosensory_bluefruit.h"
+#include "test_util.h"
+
+static const int kMotors = 4;
+static const int kFrameMs = 16;
+static const uint32_t kTrackFrames = 200;
+
+static NeosensoryBluefruit neo;
+static uint8_t track_data[NEO_TRACK_HEADER_SIZE + kTrackFrames * (kMotors + 1)];
+static size_t track_len;
+
+/** @brief Plays the test track with a queue cap, and checks every frame is
+ *	sent without the queue model going over the cap
+ */
+static void playWithQueueCap(uint16_t max_frames) {
+	char what[96];
+	NeosensoryTrackReader track;
+	track.open(track_data, track_len);
+	neo.motorsClearQueue();
+	neo.setMaxFramesQueued(max_frames);
+	mockResetLink();
+	expect(neo.playTrack(&track), "track starts");
+	uint16_t most_queued = 0;
+	for (uint32_t t = 0; t < kTrackFrames * kFrameMs * 2 && neo.isPlayingTrack(); t++) {
+		runFor(neo, 1);
+		most_queued = max(most_queued, neo.framesQueued());
+	}
+	printf("queue cap %3u: %zu writes, position %u of %u, most queued %u\n", max_frames,
+		mock_write_count, track.position(), kTrackFrames, most_queued);
+	snprintf(what, sizeof(what), "track plays to the end with a queue cap of %u", max_frames);
+	expect(track.position() == kTrackFrames && !neo.isPlayingTrack(), what);
+	snprintf(what, sizeof(what), "queue stays within a cap of %u", max_frames);
+	expect(most_queued <= max_frames, what);
+}
+
+int main(void) {
+	uint8_t frames[kTrackFrames * kMotors];
+	for (size_t i = 0; i < sizeof(frames); i++) {
+		frames[i] = (i / kMotors) % 2 ? 200 : 20;
+	}
+	track_len = neoEncodeTrack(frames, kTrackFrames, kMotors, kFrameMs,
+		track_data, sizeof(track_data));
+	neo.connectCallback(1);
+	playWithQueueCap(neo.max_frames_queued());
+	playWithQueueCap(neo.max_frames_per_bt_package());
+	playWithQueueCap(20);
+	playWithQueueCap(5);
+	playWithQueueCap(1);
+	return testResult("track_test");
+}
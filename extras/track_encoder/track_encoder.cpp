@@ -0,0 +1,189 @@
+/*
+ * Copyright 2020 Neosensory, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Please note that while this Neosensory SDK has an Apache 2.0 license,
+ * usage of the Neosensory API to interface with Neosensory products is
+ * still  subject to the Neosensory developer terms of service located at:
+ * https://neosensory.com/legal/dev-terms-service/
+ *
+ * track_encoder.cpp - Host tool that encodes haptic tracks for
+ * NeosensoryTrackReader, and reports on existing tracks.
+ *
+ * Build on Linux or macOS from this directory with:
+ *   c++ -O2 -I../.. track_encoder.cpp ../../neosensory_haptic_track.cpp -o track_encoder
+ *
+ * Usage:
+ *   track_encoder encode <frames.csv> <track.nht> [frame_duration_ms]
+ *     Encodes a text file with one frame per line, each a list of motor
+ *     intensities between 0 and 255 separated by commas or spaces.
+ *     frame_duration_ms defaults to 16, the Buzz firmware frame duration.
+ *   track_encoder header <track.nht> <name>
+ *     Prints the track as a C array named <name> for compiling into flash.
+ *   track_encoder info <track.nht>
+ *     Memory-maps the track and prints its compression ratio and decode throughput.
+ */
+
+#include "neosensory_haptic_track.h"
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+#include <vector>
+
+static int encode(const char* csv_path, const char* track_path, int frame_duration) {
+	FILE* in = fopen(csv_path, "r");
+	if (!in) {
+		perror(csv_path);
+		return 1;
+	}
+	std::vector<uint8_t> frames;
+	int num_motors = 0;
+	uint32_t num_frames = 0;
+	char line[1024];
+	while (fgets(line, sizeof(line), in)) {
+		int motors_in_line = 0;
+		for (char* token = strtok(line, ", \t\r\n"); token; token = strtok(NULL, ", \t\r\n")) {
+			frames.push_back((uint8_t)atoi(token));
+			motors_in_line++;
+		}
+		if (motors_in_line == 0) {
+			continue;
+		}
+		if (num_motors == 0) {
+			num_motors = motors_in_line;
+		}
+		if (motors_in_line != num_motors) {
+			fprintf(stderr, "%s: frame %u has %d motors, expected %d\n",
+				csv_path, num_frames, motors_in_line, num_motors);
+			fclose(in);
+			return 1;
+		}
+		num_frames++;
+	}
+	fclose(in);
+	if (num_motors == 0 || num_motors > NEO_TRACK_MAX_MOTORS) {
+		fprintf(stderr, "%s: need 1 to %d motors per frame\n", csv_path, NEO_TRACK_MAX_MOTORS);
+		return 1;
+	}
+
+	std::vector<uint8_t> track(neoMaxEncodedTrackSize(num_frames, num_motors));
+	size_t track_len = neoEncodeTrack(frames.data(), num_frames, num_motors,
+		frame_duration, track.data(), track.size());
+	FILE* out = fopen(track_path, "wb");
+	if (!out || fwrite(track.data(), 1, track_len, out) != track_len) {
+		perror(track_path);
+		return 1;
+	}
+	fclose(out);
+	printf("%u frames of %d motors: %zu bytes raw, %zu bytes encoded (%.1fx)\n",
+		num_frames, num_motors, frames.size(), track_len,
+		(double)frames.size() / track_len);
+	return 0;
+}
+
+static const uint8_t* mapTrack(const char* track_path, size_t* track_len) {
+	int fd = open(track_path, O_RDONLY);
+	struct stat st;
+	if (fd < 0 || fstat(fd, &st) != 0) {
+		perror(track_path);
+		return NULL;
+	}
+	void* track = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (track == MAP_FAILED) {
+		perror(track_path);
+		return NULL;
+	}
+	*track_len = st.st_size;
+	return (const uint8_t*)track;
+}
+
+static int header(const char* track_path, const char* name) {
+	size_t track_len;
+	const uint8_t* track = mapTrack(track_path, &track_len);
+	if (!track) {
+		return 1;
+	}
+	printf("const uint8_t %s[%zu] = {", name, track_len);
+	for (size_t i = 0; i < track_len; i++) {
+		printf("%s0x%02X,", i % 12 == 0 ? "\n  " : " ", track[i]);
+	}
+	printf("\n};\n");
+	return 0;
+}
+
+static int info(const char* track_path) {
+	size_t track_len;
+	const uint8_t* track = mapTrack(track_path, &track_len);
+	if (!track) {
+		return 1;
+	}
+	NeosensoryTrackReader reader;
+	if (!reader.open(track, track_len)) {
+		fprintf(stderr, "%s: not a haptic track\n", track_path);
+		return 1;
+	}
+	size_t raw_len = (size_t)reader.num_frames() * reader.num_motors();
+	printf("%u frames of %u motors at %u ms (%.1f s)\n", reader.num_frames(),
+		reader.num_motors(), reader.frame_duration(),
+		reader.num_frames() * reader.frame_duration() / 1000.0);
+	printf("%zu bytes raw, %zu bytes encoded (%.1fx)\n",
+		raw_len, track_len, (double)raw_len / track_len);
+
+	// Decode one packet's worth at a time, as NeosensoryBluefruit does
+	const size_t frames_per_read = 42;
+	uint8_t frames[frames_per_read * NEO_TRACK_MAX_MOTORS];
+	const int passes = 20;
+	size_t decoded = 0;
+	struct timespec start, end;
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (int pass = 0; pass < passes; pass++) {
+		reader.rewind();
+		size_t n;
+		while ((n = reader.read(frames, frames_per_read)) > 0) {
+			decoded += n;
+		}
+		if (reader.position() != reader.num_frames()) {
+			fprintf(stderr, "%s: corrupt after frame %u\n", track_path, reader.position());
+			return 1;
+		}
+	}
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	double seconds = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+	printf("decoded %.1f M frames/s on this host\n", decoded / seconds / 1e6);
+	return 0;
+}
+
+int main(int argc, char* argv[]) {
+	if (argc >= 4 && strcmp(argv[1], "encode") == 0) {
+		return encode(argv[2], argv[3], argc >= 5 ? atoi(argv[4]) : 16);
+	}
+	if (argc == 4 && strcmp(argv[1], "header") == 0) {
+		return header(argv[2], argv[3]);
+	}
+	if (argc == 3 && strcmp(argv[1], "info") == 0) {
+		return info(argv[2]);
+	}
+	fprintf(stderr,
+		"usage: %s encode <frames.csv> <track.nht> [frame_duration_ms]\n"
+		"       %s header <track.nht> <name>\n"
+		"       %s info <track.nht>\n", argv[0], argv[0], argv[0]);
+	return 2;
+}
@@ -0,0 +1,141 @@
+/*
+ * Copyright 2020 Neosensory, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Please note that while this Neosensory SDK has an Apache 2.0 license,
+ * usage of the Neosensory API to interface with Neosensory products is
+ * still  subject to the Neosensory developer terms of service located at:
+ * https://neosensory.com/legal/dev-terms-service/
+ */
+
+/*
+	NeosensoryAddressSet.cpp - Fixed-size hashed set of Bluetooth
+	device addresses, used to allow or deny devices during a scan.
+*/
+
+#include "neosensory_address_set.h"
+#include <string.h>
+
+#if (NEO_ADDRESS_SET_CAPACITY & (NEO_ADDRESS_SET_CAPACITY - 1)) != 0
+#error "NEO_ADDRESS_SET_CAPACITY must be a power of two"
+#endif
+
+#define NEO_ADDRESS_SET_MAX_SIZE (NEO_ADDRESS_SET_CAPACITY / 4 * 3)
+
+NeosensoryAddressSet::NeosensoryAddressSet(void) {
+	clear();
+}
+
+void NeosensoryAddressSet::clear(void) {
+	memset(entries_, 0, sizeof(entries_));
+	size_ = 0;
+	max_priority_ = 0;
+}
+
+size_t NeosensoryAddressSet::size(void) {
+	return size_;
+}
+
+uint8_t NeosensoryAddressSet::max_priority(void) {
+	return max_priority_;
+}
+
+/** @brief Gets the slot an address hashes to, before probing
+ *	@note FNV-1a over the address bytes
+ */
+size_t NeosensoryAddressSet::slotFor(const uint8_t address[]) {
+	uint32_t hash = 2166136261u;
+	for (int i = 0; i < NEO_ADDRESS_LEN; i++) {
+		hash = (hash ^ address[i]) * 16777619u;
+	}
+	return hash & (NEO_ADDRESS_SET_CAPACITY - 1);
+}
+
+/** @brief Gets the slot holding an address, or the empty slot
+ *	that ends its probe sequence if it is not in the set
+ */
+size_t NeosensoryAddressSet::find(const uint8_t address[]) {
+	size_t slot = slotFor(address);
+	while (entries_[slot].used &&
+		memcmp(entries_[slot].address, address, NEO_ADDRESS_LEN) != 0) {
+		slot = (slot + 1) & (NEO_ADDRESS_SET_CAPACITY - 1);
+	}
+	return slot;
+}
+
+bool NeosensoryAddressSet::contains(const uint8_t address[], uint8_t* priority) {
+	Entry& entry = entries_[find(address)];
+	if (!entry.used) {
+		return false;
+	}
+	if (priority != NULL) {
+		*priority = entry.priority;
+	}
+	return true;
+}
+
+bool NeosensoryAddressSet::add(const uint8_t address[], uint8_t priority) {
+	Entry& entry = entries_[find(address)];
+	if (!entry.used) {
+		if (size_ >= NEO_ADDRESS_SET_MAX_SIZE) {
+			return false;
+		}
+		memcpy(entry.address, address, NEO_ADDRESS_LEN);
+		size_++;
+	}
+	entry.priority = priority;
+	entry.used = 1;
+	updateMaxPriority();
+	return true;
+}
+
+bool NeosensoryAddressSet::remove(const uint8_t address[]) {
+	size_t hole = find(address);
+	if (!entries_[hole].used) {
+		return false;
+	}
+	// Shift later entries of the probe sequence back into the hole,
+	// so that no lookup is cut short by an empty slot
+	size_t slot = hole;
+	while (true) {
+		slot = (slot + 1) & (NEO_ADDRESS_SET_CAPACITY - 1);
+		if (!entries_[slot].used) {
+			break;
+		}
+		size_t home = slotFor(entries_[slot].address);
+		bool home_in_gap = hole <= slot ?
+			(hole < home && home <= slot) : (hole < home || home <= slot);
+		if (!home_in_gap) {
+			entries_[hole] = entries_[slot];
+			hole = slot;
+		}
+	}
+	entries_[hole].used = 0;
+	size_--;
+	updateMaxPriority();
+	return true;
+}
+
+/** @brief Recomputes max_priority_
+ *	@note Scans the whole table, which is fine for occasional updates
+ *	but keeps lookups free of any bookkeeping.
+ */
+void NeosensoryAddressSet::updateMaxPriority(void) {
+	max_priority_ = 0;
+	for (size_t i = 0; i < NEO_ADDRESS_SET_CAPACITY; i++) {
+		if (entries_[i].used && entries_[i].priority > max_priority_) {
+			max_priority_ = entries_[i].priority;
+		}
+	}
+}
@@ -0,0 +1,100 @@
+/*
+ * Copyright 2020 Neosensory, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Please note that while this Neosensory SDK has an Apache 2.0 license,
+ * usage of the Neosensory API to interface with Neosensory products is
+ * still  subject to the Neosensory developer terms of service located at:
+ * https://neosensory.com/legal/dev-terms-service/
+ */
+
+/*
+    NeosensoryAddressSet.h - Fixed-size hashed set of Bluetooth
+    device addresses, used to allow or deny devices during a scan.
+*/
+
+#ifndef NeosensoryAddressSet_h
+#define NeosensoryAddressSet_h
+
+#include <stddef.h>
+#include <stdint.h>
+#include "neosensory_bluefruit_config.h"
+
+#define NEO_ADDRESS_LEN 6 /**< Bytes in a Bluetooth device address. */
+
+/** @brief Fixed-size set of Bluetooth device addresses, each with a priority.
+ *  @note An open addressing hash table with linear probing, so lookups take
+ *  constant time regardless of how many addresses are held. Holds up to 3/4 of
+ *  NEO_ADDRESS_SET_CAPACITY addresses and never allocates. Removal shifts entries
+ *  back rather than leaving tombstones, so the table never needs rebuilding.
+ *  Not safe for lookups to run while the set is updated: remove() moves entries
+ *  between slots, so a concurrent lookup can miss an address that stays in the
+ *  set. NeosensoryBluefruit updates its device list in a critical section.
+ */
+class NeosensoryAddressSet
+{
+  public:
+    /** @brief Constructor for new, empty NeosensoryAddressSet object
+     */
+    NeosensoryAddressSet(void);
+
+    /** @brief Removes all addresses.
+     */
+    void clear(void);
+
+    /** @brief Add an address, or update the priority of one already in the set.
+     *  @param[in] address The address to add, in the byte order of scan reports.
+     *  @param[in] priority Priority of the address. Higher is preferred.
+     *  @return True if the address is in the set, false if the set is full.
+     */
+    bool add(const uint8_t address[], uint8_t priority=0);
+
+    /** @brief Remove an address.
+     *  @param[in] address The address to remove, in the byte order of scan reports.
+     *  @return True if the address was in the set.
+     */
+    bool remove(const uint8_t address[]);
+
+    /** @brief Look up an address.
+     *  @param[in] address The address to look up, in the byte order of scan reports.
+     *  @param[out] priority If not NULL and the address is found, set to its priority.
+     *  @return True if the address is in the set.
+     */
+    bool contains(const uint8_t address[], uint8_t* priority=NULL);
+
+    /** @brief Get the number of addresses in the set.
+     *  @return Number of addresses in the set.
+     */
+    size_t size(void);
+
+    /** @brief Get the highest priority of any address in the set.
+     *  @return Highest priority in the set, or 0 if empty.
+     */
+    uint8_t max_priority(void);
+
+  private:
+    struct Entry {
+        uint8_t address[NEO_ADDRESS_LEN];
+        uint8_t used;
+        uint8_t priority;
+    };
+    Entry entries_[NEO_ADDRESS_SET_CAPACITY];
+    size_t size_;
+    uint8_t max_priority_;
+    size_t slotFor(const uint8_t address[]);
+    size_t find(const uint8_t address[]);
+    void updateMaxPriority(void);
+};
+
+#endif
@@ -49,19 +49,90 @@ NeosensoryBluefruit::NeosensoryBluefruit(char device_id[], uint8_t num_motors,
  , wb_read_characteristic_(wb_read_char_uuid_)
 {
 	NeoBluefruit = this;
+	device_list_mode_ = NEO_DEVICE_LIST_ALLOW;
+	priority_window_ms_ = 0;
 	setDeviceId(device_id);
+#if NEO_BOUNDED_RAM
+	num_motors_ = min(num_motors, NEO_MAX_MOTORS);
+#else
 	num_motors_ = num_motors;
+#endif
 	max_vibration = initial_max_vibration;
 	min_vibration = initial_min_vibration;
 
 	// TODO: get this from firmware rather than hardcoding
 	firmware_frame_duration_ = 16;
 	uint8_t mtu = 247;
-	max_frames_per_bt_package_ = (uint8_t)((mtu - 17) / (num_motors_ * (4 / 3.0f)));
-
+	max_write_len_ = mtu - 3;
+	// Most frames whose "motors vibrate <base64>\n" command fits in a single write
+	size_t max_motor_bytes = (max_write_len_ - strlen("motors vibrate \n")) / 4 * 3;
+	max_frames_per_bt_package_ = min(max_motor_bytes / max(num_motors_, 1), 255);
+
+#if NEO_BOUNDED_RAM
+	previous_motor_array_ = storage_.previous_motors;
+	stream_motor_array_ = storage_.stream_motors;
+	motor_calibrations_ = storage_.motor_calibrations;
+	motor_tables_ = storage_.motor_tables;
+	held_frames_ = storage_.held_frames;
+#else
 	previous_motor_array_ = (uint8_t*)malloc(sizeof(uint8_t) * num_motors_);
+	stream_motor_array_ = (uint8_t*)malloc(sizeof(uint8_t) * num_motors_);
+	motor_calibrations_ = (NeoMotorCalibration*)malloc(
+		sizeof(NeoMotorCalibration) * num_motors_);
+	motor_tables_ = (uint8_t*)malloc(
+		sizeof(uint8_t) * num_motors_ * NEO_CALIBRATION_TABLE_SIZE);
+	held_frames_ = (uint8_t*)malloc(
+		sizeof(uint8_t) * num_motors_ * max_frames_per_bt_package_);
+#endif
 	memset(previous_motor_array_, 0, sizeof(uint8_t) * num_motors_);
+	memset(stream_motor_array_, 0, sizeof(uint8_t) * num_motors_);
+	stream_frame_pending_ = false;
+	sparse_pending_ = false;
+	pending_motor_updates_ = 0;
+	last_motor_flush_ms_ = millis();
+	resetSparseStats();
+	alert_active_ = false;
+	alert_frames_discarded_ = 0;
+
+	memset(motor_calibrations_, 0, sizeof(NeoMotorCalibration) * num_motors_);
+	for (int i = 0; i < num_motors_; i++) {
+		motor_calibrations_[i].curve = NEO_CURVE_EXPONENTIAL;
+		motor_calibrations_[i].gamma = 1;
+	}
+	// Forces the first applyGlobalVibrationRange to build every table
+	applied_min_vibration_ = ~min_vibration;
+	applied_max_vibration_ = ~max_vibration;
+	applyGlobalVibrationRange();
+	max_frames_queued_ = max_frames_per_bt_package_ * 3 / 2;
+	track_ = NULL;
+	conn_handle_ = BLE_CONN_HANDLE_INVALID;
+	latency_budget_ms_ = 0;
+	hold_ms_ = 0;
+	conn_interval_ = 0;
+	held_count_ = 0;
+	held_sparse_ = false;
+	resetLinkStats();
+#if NEO_ENABLE_LEDS
+	memset(led_animations_, 0, sizeof(led_animations_));
+	memset(led_sent_colors_, 0, sizeof(led_sent_colors_));
+	memset(led_sent_intensities_, 0, sizeof(led_sent_intensities_));
+	leds_known_ = false;
+	leds_animating_ = false;
+	leds_synced_ = false;
+	led_sent_ms_ = millis();
+	led_command_len_ = 0;
+#endif
+	resetQueueModel();
 	is_authorized_ = false;
+	externalConnectedCallback = NULL;
+	externalDisconnectedCallback = NULL;
+	externalReadNotifyCallback = NULL;
+#if NEO_ENABLE_BUTTONS
+	externalButtonPressCallback = NULL;
+#endif
+	jsonStarted_ = false;
+	jsonLength_ = 0;
+	jsonMessage_[0] = '\0';
 }
 
 
@@ -93,22 +164,104 @@ void NeosensoryBluefruit::begin(void) {
 	Bluefruit.Scanner.useActiveScan(false);
 }
 
+/** @brief Converts a device_id into an array of address bytes
+ *	@param[in] device_id The device_id, e.g. "F2 AD 50 EA 96 31"
+ *	@param[out] address Array of BLE_GAP_ADDR_LEN bytes to fill, in band name order.
+ */
+void parseDeviceId(char device_id[], uint8_t address[])
+{
+	for (int i = 0; i < BLE_GAP_ADDR_LEN; i++) {
+		address[i] = (uint8_t)strtol(device_id, &device_id, 16);
+	}
+}
+
+/** @brief Reverses an address from band name order into scan report order
+ *	@param[in] address Address in band name order
+ *	@param[out] report_address Address in the order scan reports use
+ */
+void toReportAddress(const uint8_t address[], uint8_t report_address[])
+{
+	for (int i = 0; i < BLE_GAP_ADDR_LEN; i++) {
+		report_address[BLE_GAP_ADDR_LEN - (i + 1)] = address[i];
+	}
+}
+
 /** @brief Sets private variable device_address_ from given device_id
  *	@param[in] device_id The device_id of the hardware to connect to
  *	@note Converts a character array into an array of bytes
  */
 void NeosensoryBluefruit::setDeviceAddress(char device_id[])
 {
-	for (int i = 0; i < BLE_GAP_ADDR_LEN; i++) {
-		device_address_[i] = (uint8_t)strtol(device_id, &device_id, 16);
-	}
+	parseDeviceId(device_id, device_address_);
+}
+
+/** @brief Updates connect_to_any_neo_device_ and drops any pending
+ *	candidate after the device list or its mode changes
+ *	@note The device list is read by scanCallback(), which runs in the
+ *	Bluefruit task. Callers change the list and call this inside a
+ *	critical section, so a scan report never sees a half-updated list,
+ *	e.g. a denied address missing while remove() shifts entries back.
+ */
+void NeosensoryBluefruit::updateDeviceListMode(void) {
+	connect_to_any_neo_device_ = device_list_mode_ == NEO_DEVICE_LIST_DENY ||
+		device_list_.size() == 0;
+	has_candidate_ = false;
 }
 
 void NeosensoryBluefruit::setDeviceId(char new_device_id[]) {
-	connect_to_any_neo_device_ = strlen(new_device_id) <= 0;
-	if (!connect_to_any_neo_device_) {
-		setDeviceAddress(new_device_id);
+	// Critical sections nest, so the list is never seen empty between clear and add
+	taskENTER_CRITICAL();
+	device_list_.clear();
+	device_list_mode_ = NEO_DEVICE_LIST_ALLOW;
+	if (strlen(new_device_id) > 0) {
+		addDeviceId(new_device_id);
 	}
+	updateDeviceListMode();
+	taskEXIT_CRITICAL();
+}
+
+bool NeosensoryBluefruit::addDeviceId(char device_id[], uint8_t priority) {
+	if (strlen(device_id) <= 0) {
+		return false;
+	}
+	setDeviceAddress(device_id);
+	uint8_t report_address[BLE_GAP_ADDR_LEN];
+	toReportAddress(device_address_, report_address);
+	taskENTER_CRITICAL();
+	bool added = device_list_.add(report_address, priority);
+	updateDeviceListMode();
+	taskEXIT_CRITICAL();
+	return added;
+}
+
+bool NeosensoryBluefruit::removeDeviceId(char device_id[]) {
+	uint8_t address[BLE_GAP_ADDR_LEN];
+	uint8_t report_address[BLE_GAP_ADDR_LEN];
+	parseDeviceId(device_id, address);
+	toReportAddress(address, report_address);
+	taskENTER_CRITICAL();
+	bool removed = device_list_.remove(report_address);
+	updateDeviceListMode();
+	taskEXIT_CRITICAL();
+	return removed;
+}
+
+void NeosensoryBluefruit::clearDeviceIds(void) {
+	taskENTER_CRITICAL();
+	device_list_.clear();
+	updateDeviceListMode();
+	taskEXIT_CRITICAL();
+}
+
+void NeosensoryBluefruit::setDeviceListMode(NeoDeviceListMode mode) {
+	taskENTER_CRITICAL();
+	device_list_mode_ = mode;
+	updateDeviceListMode();
+	taskEXIT_CRITICAL();
+}
+
+void NeosensoryBluefruit::setPriorityWindow(uint16_t window_ms) {
+	priority_window_ms_ = window_ms;
 }
 
 uint8_t* NeosensoryBluefruit::getDeviceAddress(void)
@@ -126,44 +279,38 @@ bool NeosensoryBluefruit::isConnected(void) {
 	return Bluefruit.Central.connected();
 }
 
-/** @brief Checks that a report address, found during a scan,
- *  matches the address of the device NeosensoryBluefruit is searching for.
- *  @param[in] foundAddress The address found during the scan.
- *  @note Address will be reversed order from band name array.
- */
-bool NeosensoryBluefruit::checkAddressMatches(uint8_t foundAddress[]) {
-	for (int i = 0; i < BLE_GAP_ADDR_LEN; i++) {
-		if (device_address_[i] != 
-			foundAddress[BLE_GAP_ADDR_LEN - (i + 1)]) {
-			return false;
-		}
-	}
-	return true;
-}
-
 /** @brief Checks if the found BLE report belongs to a Neosensory device
  *  @param[in] report The found report
  *  @note For now, just checks that the string "Buzz" is in the 
  *  advertising data.
  */
 bool NeosensoryBluefruit::checkIsNeosensory(ble_gap_evt_adv_report_t* report) {
-	String advertising_data = "";
-	for (int i = 7; i < report->data.len; i++) {
-		advertising_data += (char)report->data.p_data[i];
+	static const char name[] = "Buzz";
+	const size_t name_len = sizeof(name) - 1;
+	for (int i = 7; i + name_len <= report->data.len; i++) {
+		if (memcmp(report->data.p_data + i, name, name_len) == 0) {
+			return true;
+		}
 	}
-	bool found = advertising_data.indexOf("Buzz") != -1;
-	return found;
+	return false;
 }
 
 /** @brief Checks if NeosensoryBluefruit should connect to the found BLE report.
  *  @param[in] report The found report
+ *  @param[out] priority Set to the device's priority in the device list. Devices
+ *  that are not looked up by priority get the highest priority in the list.
+ *  @note Constant time: a single hash lookup in the device list.
  */
-bool NeosensoryBluefruit::checkDevice(ble_gap_evt_adv_report_t* report) {
-	if (connect_to_any_neo_device_) {
-		return checkIsNeosensory(report);
-	} else {
-		return checkAddressMatches(report->peer_addr.addr);
+bool NeosensoryBluefruit::checkDevice(ble_gap_evt_adv_report_t* report, uint8_t* priority) {
+	*priority = device_list_.max_priority();
+	if (!connect_to_any_neo_device_) {
+		return device_list_.contains(report->peer_addr.addr, priority);
+	}
+	if (!checkIsNeosensory(report)) {
+		return false;
 	}
+	return device_list_mode_ != NEO_DEVICE_LIST_DENY ||
+		!device_list_.contains(report->peer_addr.addr);
 }
 
 
@@ -174,7 +321,13 @@ bool NeosensoryBluefruit::isAuthorized(void) {
 }
 
 void NeosensoryBluefruit::sendCommand(char cmd[]) {
-	wb_write_characteristic_.write(cmd, strlen(cmd));
+	size_t len = strlen(cmd);
+	wb_write_characteristic_.write(cmd, len);
+	uint32_t packets = (len + max_write_len_ - 1) / max_write_len_;
+	link_stats_.writes++;
+	link_stats_.packets += packets;
+	link_stats_.bytes += len;
+	link_stats_.radio_on_us += packets * NEO_RADIO_PACKET_US + len * NEO_RADIO_BYTE_US;
 }
 
 void NeosensoryBluefruit::authorizeDeveloper(void) {
@@ -200,10 +353,14 @@ void NeosensoryBluefruit::motorsStart(void) {
 
 void NeosensoryBluefruit::motorsStop(void) {
 	sendCommand("motors stop\n");
+	dropHeldFrames();
+	resetQueueModel();
 }
 
 void NeosensoryBluefruit::motorsClearQueue(void) {
 	sendCommand("motors clear_queue\n");
+	dropHeldFrames();
+	resetQueueModel();
 }
 
 void NeosensoryBluefruit::deviceBattery(void) {
@@ -219,32 +376,125 @@ void NeosensoryBluefruit::audioStop(void) {
 }
 
 /** @brief Looks for a JSON object in the input data, or in a combination of this data and previous data.
+ *  @note A message that does not fit in jsonMessage_ is discarded.
  */
 void NeosensoryBluefruit::parseCliData(uint8_t* data, uint16_t len) {
 	for (int i = 0; i < len; i++) {
 		if (data[i] == '{') {
 			jsonStarted_ = true;
-			jsonMessage_ = "";
+			jsonLength_ = 0;
 		}
 		if (jsonStarted_) {
-			jsonMessage_ += (char)data[i];
+			if (jsonLength_ + 1 >= NEO_JSON_BUFFER_SIZE) {
+				jsonStarted_ = false;
+				jsonLength_ = 0;
+			} else {
+				jsonMessage_[jsonLength_++] = (char)data[i];
+			}
+			jsonMessage_[jsonLength_] = '\0';
 		}
-		if (data[i] == '}') {
+		if (jsonStarted_ && data[i] == '}') {
 			jsonStarted_ = false;
 			handleCliJson(jsonMessage_);
 		}
 	}
 }
 
+/** @brief Finds the value of a key in a CLI JSON message
+ *	@param[in] jsonMessage The message
+ *	@param[in] key The key, without quotes
+ *	@return Pointer to the start of the key's value, or NULL if the key is not in the message
+ */
+const char* findJsonValue(const char* jsonMessage, const char* key) {
+	const char* value = strstr(jsonMessage, key);
+	if (value == NULL) {
+		return NULL;
+	}
+	value += strlen(key);
+	while (*value == '"' || *value == ':' || *value == ' ') {
+		value++;
+	}
+	return value;
+}
+
 /** @brief Handles CLI JSON responses, by granting authorization for instance.
- *  @note This method can be adjusted to handle more response messages. For instance,
- *  this method could parse the JSON and see if it handles information about the battery level
- *  and then update a variable that holds the latest read battery level.
+ *  @note Called once per complete message, which is searched once for each kind
+ *  of response and publishes the matching events. This method can be adjusted to
+ *  handle more response messages.
  */
-void NeosensoryBluefruit::handleCliJson(String jsonMessage) {
-	if (jsonMessage.indexOf('Developer API access granted!') != -1) {
+void NeosensoryBluefruit::handleCliJson(const char* jsonMessage) {
+	NeoEvent event;
+	if (strstr(jsonMessage, "Developer API access granted!") != NULL) {
 		is_authorized_ = true;
+		event.type = NEO_EVENT_AUTHORIZED;
+		publishEvent(event);
+	}
+	const char* battery = findJsonValue(jsonMessage, "battery_soc");
+	if (battery != NULL && *battery >= '0' && *battery <= '9') {
+		event.type = NEO_EVENT_BATTERY;
+		event.battery.percent = atof(battery);
+		publishEvent(event);
+	}
+#if NEO_ENABLE_BUTTONS
+	const char* button = findJsonValue(jsonMessage, "button_val");
+	if (button != NULL && *button >= '0' && *button <= '9') {
+		handleButton(atoi(button));
 	}
+#endif
+}
+
+#if NEO_ENABLE_BUTTONS
+/** @brief Decodes a button report into gestures and publishes them
+ *	@param[in] button Id of the button reported
+ */
+void NeosensoryBluefruit::handleButton(uint8_t button) {
+	NeoButtonGesture gestures[2];
+	size_t num_gestures = button_gestures_.report(button, millis(), gestures);
+	for (size_t i = 0; i < num_gestures; i++) {
+		if (gestures[i] == NEO_BUTTON_PRESS && externalButtonPressCallback) {
+			externalButtonPressCallback(button);
+		}
+		NeoEvent event;
+		event.type = NEO_EVENT_BUTTON;
+		event.button.button = button;
+		event.button.gesture = gestures[i];
+		publishEvent(event);
+	}
+}
+
+/** @brief Publishes long presses of held buttons as soon as they are long enough
+ */
+void NeosensoryBluefruit::updateButtons(void) {
+	uint8_t buttons[NEO_MAX_BUTTONS];
+	size_t num_buttons = button_gestures_.poll(millis(), buttons);
+	for (size_t i = 0; i < num_buttons; i++) {
+		NeoEvent event;
+		event.type = NEO_EVENT_BUTTON;
+		event.button.button = buttons[i];
+		event.button.gesture = NEO_BUTTON_LONG_PRESS;
+		publishEvent(event);
+	}
+}
+#endif
+
+
+/* Events */
+
+bool NeosensoryBluefruit::subscribe(
+	NeoEventType type, NeoEventHandler handler, void* context) {
+	return events_.subscribe(type, handler, context);
+}
+
+bool NeosensoryBluefruit::unsubscribe(
+	NeoEventType type, NeoEventHandler handler, void* context) {
+	return events_.unsubscribe(type, handler, context);
+}
+
+/** @brief Stamps an event with the current time and publishes it
+ */
+void NeosensoryBluefruit::publishEvent(NeoEvent& event) {
+	event.time_ms = millis();
+	events_.publish(event);
 }
 
 
@@ -263,6 +513,54 @@ uint8_t NeosensoryBluefruit::max_frames_per_bt_package(void) {
 }
 
 
+/* Device Queue Model */
+
+/** @brief Marks the device motor queue as empty.
+ */
+void NeosensoryBluefruit::resetQueueModel(void) {
+	frames_queued_ = 0;
+	queue_updated_ms_ = millis();
+}
+
+/** @brief Removes the frames the device has played since the last update
+ *  from frames_queued_.
+ *  @note queue_updated_ms_ only advances by whole frames so that partially
+ *  played frames are not lost between updates.
+ */
+void NeosensoryBluefruit::updateQueueModel(void) {
+	uint32_t now = millis();
+	if (frames_queued_ == 0) {
+		queue_updated_ms_ = now;
+		return;
+	}
+	uint32_t frames_played = (now - queue_updated_ms_) / firmware_frame_duration_;
+	if (frames_played >= frames_queued_) {
+		frames_queued_ = 0;
+		queue_updated_ms_ = now;
+		return;
+	}
+	frames_queued_ -= frames_played;
+	queue_updated_ms_ += frames_played * firmware_frame_duration_;
+}
+
+uint16_t NeosensoryBluefruit::framesQueued(void) {
+	updateQueueModel();
+	return frames_queued_;
+}
+
+bool NeosensoryBluefruit::canAccept(size_t num_frames) {
+	return framesQueued() + num_frames <= max_frames_queued_;
+}
+
+uint16_t NeosensoryBluefruit::max_frames_queued(void) {
+	return max_frames_queued_;
+}
+
+void NeosensoryBluefruit::setMaxFramesQueued(uint16_t max_frames) {
+	max_frames_queued_ = max_frames;
+}
+
+
 /* Motor Control */
 
 /** @brief Translates a linear intensity value into a 
@@ -280,26 +578,300 @@ uint8_t linearIntensityToMotorSpace(
 							 (exp(1) - 1) * (max_intensity - min_intensity) + min_intensity);
 }
 
+/** @brief Translates a linear intensity value into a motor
+ *	intensity value on a power curve
+ */
+uint8_t gammaIntensityToMotorSpace(
+	float linear_intensity, float gamma, uint8_t min_intensity, uint8_t max_intensity) {
+	if (linear_intensity <= 0) {
+		return 0;
+	}
+	if (linear_intensity >= 1) {
+		return max_intensity;
+	}
+	if (gamma <= 0) {
+		gamma = 1;
+	}
+	return uint8_t(pow(linear_intensity, gamma) *
+		(max_intensity - min_intensity) + min_intensity);
+}
+
+/** @brief Translates a linear intensity value into a motor
+ *	intensity value on a calibration's piecewise linear curve
+ *	@note Inputs outside of the curve's points are clamped to its first
+ *	and last points. A curve without points is a straight line.
+ */
+uint8_t piecewiseIntensityToMotorSpace(
+	float linear_intensity, const NeoMotorCalibration& calibration) {
+	if (linear_intensity <= 0) {
+		return 0;
+	}
+	float x = min(linear_intensity, 1.0f) * 255;
+	float y = x;
+	uint8_t last = calibration.num_points - 1;
+	if (calibration.num_points == 0) {
+		y = x;
+	} else if (x <= calibration.points_in[0]) {
+		y = calibration.points_out[0];
+	} else if (x >= calibration.points_in[last]) {
+		y = calibration.points_out[last];
+	} else {
+		int k = 0;
+		while (x >= calibration.points_in[k + 1]) {
+			k++;
+		}
+		float x0 = calibration.points_in[k];
+		float x1 = calibration.points_in[k + 1];
+		float y0 = calibration.points_out[k];
+		float y1 = calibration.points_out[k + 1];
+		y = y0 + (x - x0) / (x1 - x0) * (y1 - y0);
+	}
+	return uint8_t(y / 255 * (calibration.max_vibration - calibration.min_vibration) +
+		calibration.min_vibration);
+}
+
+/** @brief Gets the index of a motor's lookup table that holds a linear intensity
+ *	@note Index 0 is reserved for an input of 0, which always turns the motor off,
+ *	so that small non-zero inputs still play at the motor's minimum intensity.
+ */
+size_t linearIntensityToTableIndex(float linear_intensity) {
+	if (linear_intensity <= 0) {
+		return 0;
+	}
+	if (linear_intensity >= 1) {
+		return NEO_CALIBRATION_TABLE_SIZE - 1;
+	}
+	size_t index = (size_t)(linear_intensity * (NEO_CALIBRATION_TABLE_SIZE - 1) + 0.5f);
+	return index == 0 ? 1 : index;
+}
+
+/** @brief Compiles a motor's calibration into its lookup table
+ *	@param[in] motor Index of the motor
+ */
+void NeosensoryBluefruit::buildMotorTable(uint8_t motor) {
+	const NeoMotorCalibration& calibration = motor_calibrations_[motor];
+	uint8_t* table = motor_tables_ + motor * NEO_CALIBRATION_TABLE_SIZE;
+	table[0] = 0;
+	for (int i = 1; i < NEO_CALIBRATION_TABLE_SIZE; i++) {
+		float linear_intensity = i / (float)(NEO_CALIBRATION_TABLE_SIZE - 1);
+		switch (calibration.curve) {
+			case NEO_CURVE_GAMMA:
+				table[i] = gammaIntensityToMotorSpace(linear_intensity, calibration.gamma,
+					calibration.min_vibration, calibration.max_vibration);
+				break;
+			case NEO_CURVE_PIECEWISE:
+				table[i] = piecewiseIntensityToMotorSpace(linear_intensity, calibration);
+				break;
+			default:
+				table[i] = linearIntensityToMotorSpace(linear_intensity,
+					calibration.min_vibration, calibration.max_vibration);
+				break;
+		}
+	}
+}
+
+/** @brief Applies min_vibration and max_vibration to every motor if
+ *	either has changed since they were last applied
+ */
+void NeosensoryBluefruit::applyGlobalVibrationRange(void) {
+	if (min_vibration == applied_min_vibration_ &&
+		max_vibration == applied_max_vibration_) {
+		return;
+	}
+	applied_min_vibration_ = min_vibration;
+	applied_max_vibration_ = max_vibration;
+	for (int i = 0; i < num_motors_; i++) {
+		motor_calibrations_[i].min_vibration = min_vibration;
+		motor_calibrations_[i].max_vibration = max_vibration;
+		buildMotorTable(i);
+	}
+}
+
 /** @brief Translates an array of intensities from linear space to motor space
  *	@param[in] lin_array Array of intensities from (0, 1)
  *	@param[out] motor_space_array Array of motor intensities 
  *	corresponding to the linear intensities
- *	@param[in] array_size Number of values in the arrays
- *	@note Translates an array of intensities between (0, 1) to 
- *	(THRESHOLD_INTENSITY, MAX_INTENSITY) on an exponential curve,
- *	so that each linear step in the lin_array feels like a linear
- *	change on the skin. This is due to the Weber Curve, which 
+ *	@param[in] array_size Number of values in the arrays. Values are
+ *	assigned to motors in order, wrapping around every num_motors_ values.
+ *	@note Each value is looked up in its motor's calibration table. By default
+ *	this translates intensities between (0, 1) to (min_vibration, max_vibration)
+ *	on an exponential curve, so that each linear step in the lin_array feels
+ *	like a linear change on the skin. This is due to the Weber Curve, which 
  *	shows that larger increases in intensity are needed for larger
  *	intensities than for lesser intensities, if the same 
  *	perceptual change is to be felt.
  */
 void NeosensoryBluefruit::getMotorIntensitiesFromLinArray(
 	float lin_array[], uint8_t motor_space_array[], size_t array_size) {
+	applyGlobalVibrationRange();
+	uint8_t motor = 0;
 	for (int i = 0; i < array_size; i++) {
-		float input = lin_array[i];
-		motor_space_array[i] = linearIntensityToMotorSpace(
-			input, min_vibration, max_vibration);
+		const uint8_t* table = motor_tables_ + motor * NEO_CALIBRATION_TABLE_SIZE;
+		motor_space_array[i] = table[linearIntensityToTableIndex(lin_array[i])];
+		if (++motor == num_motors_) {
+			motor = 0;
+		}
+	}
+}
+
+
+/* Tracks */
+
+bool NeosensoryBluefruit::playTrack(NeosensoryTrackReader* track) {
+	if (track->num_motors() != num_motors_ ||
+		track->frame_duration() != firmware_frame_duration_) {
+		return false;
+	}
+	track_ = track;
+	track_timed_ = false;
+	track_resync_ = false;
+	return true;
+}
+
+void NeosensoryBluefruit::stopTrack(void) {
+	track_ = NULL;
+}
+
+bool NeosensoryBluefruit::isPlayingTrack(void) {
+	return track_ != NULL && !track_->finished();
+}
+
+/** @brief Sends the next packet of the playing track once the device
+ *	queue has room for at least half a packet
+ *	@note Sending before the queue drains keeps playback gapless, and
+ *	waiting for half a packet of room keeps packets large.
+ */
+void NeosensoryBluefruit::updateTrack(void) {
+	if (!isPlayingTrack()) {
+		track_ = NULL;
+		return;
+	}
+	if (isPlayingAlert()) {
+		return;
+	}
+	if (track_resync_) {
+		// Skip the frames whose time passed while an alert played
+		int32_t elapsed = (int32_t)(millis() - track_start_ms_);
+		track_->seek(elapsed > 0 ? elapsed / firmware_frame_duration_ : 0);
+		track_resync_ = false;
+		if (!isPlayingTrack()) {
+			return;
+		}
+	}
+	uint16_t queued = framesQueued();
+	if (queued >= max_frames_queued_) {
+		return;
+	}
+	size_t room = min(max_frames_queued_ - queued, max_frames_per_bt_package_);
+	size_t frames_left = track_->num_frames() - track_->position();
+	// Refill at half a packet, or at the whole queue when it is capped lower
+	size_t min_batch = min(max_frames_per_bt_package_ / 2, max_frames_queued_);
+	if (room < min_batch && room < frames_left) {
+		return;
+	}
+	if (!track_timed_) {
+		// Fix the track's timeline: its current frame plays once the queue drains
+		track_start_ms_ = millis() +
+			(queued - track_->position()) * firmware_frame_duration_;
+		track_timed_ = true;
+	}
+	uint8_t motor_intensities[num_motors_ * room];
+	size_t num_frames = track_->read(motor_intensities, room);
+	if (num_frames > 0) {
+		sendMotorCommand(motor_intensities, num_frames);
+	}
+}
+
+
+/* Calibration */
+
+void NeosensoryBluefruit::setMotorCalibration(
+	uint8_t motor, const NeoMotorCalibration& calibration) {
+	if (motor >= num_motors_) {
+		return;
+	}
+	applyGlobalVibrationRange();
+	motor_calibrations_[motor] = calibration;
+	motor_calibrations_[motor].num_points = min(calibration.num_points, NEO_CURVE_MAX_POINTS);
+	buildMotorTable(motor);
+}
+
+NeoMotorCalibration NeosensoryBluefruit::getMotorCalibration(uint8_t motor) {
+	applyGlobalVibrationRange();
+	return motor_calibrations_[min(motor, num_motors_ - 1)];
+}
+
+void NeosensoryBluefruit::setMotorRange(
+	uint8_t motor, uint8_t min_intensity, uint8_t max_intensity) {
+	if (motor >= num_motors_) {
+		return;
 	}
+	NeoMotorCalibration calibration = getMotorCalibration(motor);
+	calibration.min_vibration = min_intensity;
+	calibration.max_vibration = max_intensity;
+	setMotorCalibration(motor, calibration);
+}
+
+size_t NeosensoryBluefruit::calibrationSize(void) {
+	return NEO_CALIBRATION_HEADER_SIZE + NEO_CALIBRATION_MOTOR_SIZE * num_motors_;
+}
+
+/** @note Layout is a header of 'N', 'C', format version and number of motors,
+ *	followed by each motor's min, max, curve, number of points, gamma in
+ *	thousandths (little endian uint16), inputs and outputs of the points.
+ */
+size_t NeosensoryBluefruit::saveCalibration(uint8_t buffer[], size_t buffer_len) {
+	if (buffer_len < calibrationSize()) {
+		return 0;
+	}
+	applyGlobalVibrationRange();
+	uint8_t* p = buffer;
+	*p++ = 'N';
+	*p++ = 'C';
+	*p++ = 1;
+	*p++ = num_motors_;
+	for (int i = 0; i < num_motors_; i++) {
+		const NeoMotorCalibration& calibration = motor_calibrations_[i];
+		uint16_t gamma = (uint16_t)(constrain(calibration.gamma, 0.0f, 65.535f) * 1000 + 0.5f);
+		*p++ = calibration.min_vibration;
+		*p++ = calibration.max_vibration;
+		*p++ = calibration.curve;
+		*p++ = calibration.num_points;
+		*p++ = gamma & 0xFF;
+		*p++ = gamma >> 8;
+		memcpy(p, calibration.points_in, NEO_CURVE_MAX_POINTS);
+		p += NEO_CURVE_MAX_POINTS;
+		memcpy(p, calibration.points_out, NEO_CURVE_MAX_POINTS);
+		p += NEO_CURVE_MAX_POINTS;
+	}
+	return p - buffer;
+}
+
+bool NeosensoryBluefruit::loadCalibration(const uint8_t buffer[], size_t buffer_len) {
+	if (buffer_len < calibrationSize() || buffer[0] != 'N' || buffer[1] != 'C' ||
+		buffer[2] != 1 || buffer[3] != num_motors_) {
+		return false;
+	}
+	const uint8_t* motor_data = buffer + NEO_CALIBRATION_HEADER_SIZE;
+	for (int i = 0; i < num_motors_; i++) {
+		const uint8_t* p = motor_data + i * NEO_CALIBRATION_MOTOR_SIZE;
+		if (p[2] > NEO_CURVE_PIECEWISE || p[3] > NEO_CURVE_MAX_POINTS) {
+			return false;
+		}
+	}
+	for (int i = 0; i < num_motors_; i++) {
+		const uint8_t* p = motor_data + i * NEO_CALIBRATION_MOTOR_SIZE;
+		NeoMotorCalibration calibration;
+		calibration.min_vibration = p[0];
+		calibration.max_vibration = p[1];
+		calibration.curve = p[2];
+		calibration.num_points = p[3];
+		calibration.gamma = (p[4] | (p[5] << 8)) / 1000.0f;
+		memcpy(calibration.points_in, p + 6, NEO_CURVE_MAX_POINTS);
+		memcpy(calibration.points_out, p + 6 + NEO_CURVE_MAX_POINTS, NEO_CURVE_MAX_POINTS);
+		setMotorCalibration(i, calibration);
+	}
+	return true;
 }
 
 /** @brief Checks if two arrays are equal
@@ -341,28 +913,109 @@ void encodeMotorIntensities(
  */
 void NeosensoryBluefruit::sendMotorCommand(uint8_t motor_intensities[], size_t num_frames) {
 	num_frames = min(max_frames_per_bt_package_, num_frames);
-	char encoded_motor_intensities[base64_enc_len(sizeof(uint8_t) * num_motors_ * num_frames)];
+	if (num_frames == 0) {
+		return;
+	}
+	// Built into one buffer so the whole command goes out in a single write
+	static const char prefix[] = "motors vibrate ";
+	const size_t prefix_len = sizeof(prefix) - 1;
+#if NEO_ENABLE_LEDS
+	const size_t led_len = led_command_len_ > 0 ? NEO_LED_COMMAND_SIZE : 0;
+#else
+	const size_t led_len = 0;
+#endif
+	char command[prefix_len +
+		base64_enc_len(sizeof(uint8_t) * num_motors_ * num_frames) + 2 + led_len];
+	memcpy(command, prefix, prefix_len);
 	encodeMotorIntensities(
-		motor_intensities, num_motors_ * num_frames, encoded_motor_intensities);
-	sendCommand("motors vibrate ");
-	sendCommand(encoded_motor_intensities);
-	sendCommand("\n");
+		motor_intensities, num_motors_ * num_frames, command + prefix_len);
+	strcat(command, "\n");
+
+	// The device holds the last frame until another arrives
+	memcpy(previous_motor_array_, motor_intensities + (num_frames - 1) * num_motors_,
+		sizeof(uint8_t) * num_motors_);
+#if NEO_ENABLE_LEDS
+	// A pending LED update rides along if both fit in one packet, restaged
+	// so that LEDs following the motors match this packet
+	if (led_len > 0 && leds_animating_) {
+		stageLeds(millis(), true);
+	}
+	size_t len = strlen(command);
+	if (led_len > 0 && len + led_command_len_ <= max_write_len_) {
+		memcpy(command + len, led_command_, led_command_len_ + 1);
+		link_stats_.led_bytes += led_command_len_;
+		link_stats_.led_updates++;
+		link_stats_.led_piggybacked++;
+		led_command_len_ = 0;
+		led_sent_ms_ = millis();
+	}
+#endif
+	sendCommand(command);
+
+	updateQueueModel();
+	frames_queued_ = min(0xFFFF, frames_queued_ + num_frames);
 }
 
 void NeosensoryBluefruit::vibrateMotors(float intensities[]) {
-	uint8_t motor_intensities[num_motors_];
-	getMotorIntensitiesFromLinArray(intensities, motor_intensities, num_motors_);
-
-	if (compareArrays(motor_intensities, previous_motor_array_, num_motors_)) {
+	getMotorIntensitiesFromLinArray(intensities, stream_motor_array_, num_motors_);
+	// The full frame replaces any pending sparse updates
+	sparse_pending_ = false;
+	pending_motor_updates_ = 0;
+	if (isPlayingAlert()) {
+		stream_frame_pending_ = true;
 		return;
 	}
-	memcpy(previous_motor_array_, motor_intensities, sizeof(uint8_t) * num_motors_);
 
-	sendMotorCommand(motor_intensities);
+	sendStreamFrame();
+}
+
+/** @brief Sends stream_motor_array_ if it differs from the last frame sent,
+ *	and clears pending sparse updates, which it includes
+ */
+void NeosensoryBluefruit::sendStreamFrame(void) {
+	bool sparse = sparse_pending_;
+	if (sparse) {
+		sparse_stats_.flushes++;
+		sparse_stats_.last_merged = pending_motor_updates_;
+		sparse_stats_.max_merged = max(sparse_stats_.max_merged, pending_motor_updates_);
+	}
+	stream_frame_pending_ = false;
+	sparse_pending_ = false;
+	pending_motor_updates_ = 0;
+	if (latency_budget_ms_ > 0) {
+		// Counted when the held frames are sent
+		if (holdFrame(stream_motor_array_) && sparse) {
+			held_sparse_ = true;
+		}
+		return;
+	}
+	if (compareArrays(stream_motor_array_, previous_motor_array_, num_motors_)) {
+		return;
+	}
+	sendMotorCommand(stream_motor_array_);
+	if (sparse) {
+		sparse_stats_.packets++;
+	}
 }
 
 void NeosensoryBluefruit::vibrateMotors(float *intensities[], int num_frames) {
+	if (isPlayingAlert()) {
+		return;
+	}
+	flushHeldFrames();
+	sendLinearFrames(intensities, num_frames);
+}
+
+/** @brief Converts frames of linear intensities to motor space and sends them
+ *	@param[in] intensities Nested array of intensities, one frame per outer index
+ *	@param[in] num_frames The number of frames. Clamped to max_frames_per_bt_package_.
+ *	@return The number of frames sent
+ */
+int NeosensoryBluefruit::sendLinearFrames(float *intensities[], int num_frames) {
 	num_frames = min(max_frames_per_bt_package_, num_frames);
+	if (num_frames <= 0) {
+		return 0;
+	}
 	float flat_intensities[num_motors_ * num_frames];
 	for (int i = 0; i < num_frames; ++i)
 	{
@@ -375,6 +1028,62 @@ void NeosensoryBluefruit::vibrateMotors(float *intensities[], int num_frames) {
 	getMotorIntensitiesFromLinArray(flat_intensities, motor_intensities, num_motors_ * num_frames);
 
 	sendMotorCommand(motor_intensities, num_frames);
+	return num_frames;
+}
+
+bool NeosensoryBluefruit::playAlert(float *intensities[], int num_frames, uint8_t priority) {
+	priority = max(priority, 1);
+	if (num_frames <= 0 || (isPlayingAlert() && priority < alert_priority_)) {
+		return false;
+	}
+	if (track_ != NULL && track_timed_) {
+		track_resync_ = true;
+	}
+	if (held_count_ > 0) {
+		// Held frames are dropped with the queue, but the latest one plays after the alert
+		stream_frame_pending_ = true;
+	}
+	alert_frames_discarded_ = framesQueued() + held_count_;
+	motorsClearQueue();
+	num_frames = sendLinearFrames(intensities, num_frames);
+	alert_active_ = true;
+	alert_priority_ = priority;
+	alert_end_ms_ = millis() + num_frames * firmware_frame_duration_;
+	return true;
+}
+
+uint16_t NeosensoryBluefruit::alertFramesDiscarded(void) {
+	return alert_frames_discarded_;
+}
+
+bool NeosensoryBluefruit::isPlayingAlert(void) {
+	return alert_active_ && (int32_t)(millis() - alert_end_ms_) < 0;
+}
+
+/** @brief Hands the motors back to the stream lane once an alert has played,
+ *	sending the last single frame that was requested while it played
+ */
+void NeosensoryBluefruit::updateAlert(void) {
+	if (!alert_active_ || isPlayingAlert()) {
+		return;
+	}
+	alert_active_ = false;
+	if (stream_frame_pending_) {
+		sendStreamFrame();
+	}
+}
+
+void NeosensoryBluefruit::update(void) {
+	updateAlert();
+	updateSparseMotors();
+	updateHeldFrames();
+	updateTrack();
+#if NEO_ENABLE_BUTTONS && NEO_BUTTON_REPORTS_REPEAT
+	updateButtons();
+#endif
+#if NEO_ENABLE_LEDS
+	updateLeds();
+#endif
 }
 
 void NeosensoryBluefruit::turnOffAllMotors(void) {
@@ -390,19 +1099,340 @@ void NeosensoryBluefruit::vibrateMotor(uint8_t motor, float intensity) {
 	vibrateMotors(motor_intensities);
 }
 
+
+/* Sparse Motor Updates */
+
+void NeosensoryBluefruit::setMotor(uint8_t motor, float intensity) {
+	setMotors(&motor, &intensity, 1);
+}
+
+void NeosensoryBluefruit::setMotors(
+	const uint8_t motors[], const float intensities[], size_t count) {
+	applyGlobalVibrationRange();
+	for (size_t i = 0; i < count; i++) {
+		uint8_t motor = motors[i];
+		if (motor >= num_motors_) {
+			continue;
+		}
+		const uint8_t* table = motor_tables_ + motor * NEO_CALIBRATION_TABLE_SIZE;
+		stream_motor_array_[motor] = table[linearIntensityToTableIndex(intensities[i])];
+		sparse_pending_ = true;
+		if (pending_motor_updates_ < UINT16_MAX) {
+			pending_motor_updates_++;
+		}
+		sparse_stats_.updates++;
+	}
+}
+
+void NeosensoryBluefruit::flushMotors(void) {
+	if (!sparse_pending_ || isPlayingAlert()) {
+		return;
+	}
+	last_motor_flush_ms_ = millis();
+	sendStreamFrame();
+}
+
+/** @brief Flushes pending sparse updates if a firmware frame
+ *	has passed since the last flush
+ */
+void NeosensoryBluefruit::updateSparseMotors(void) {
+	if (!sparse_pending_ ||
+		millis() - last_motor_flush_ms_ < firmware_frame_duration_) {
+		return;
+	}
+	flushMotors();
+}
+
+NeoSparseStats NeosensoryBluefruit::getSparseStats(void) {
+	return sparse_stats_;
+}
+
+void NeosensoryBluefruit::resetSparseStats(void) {
+	memset(&sparse_stats_, 0, sizeof(sparse_stats_));
+}
+
+
+/* Link */
+
+void NeosensoryBluefruit::setLatencyBudget(uint16_t budget_ms) {
+	flushHeldFrames();
+	latency_budget_ms_ = min(budget_ms, max_frames_per_bt_package_ * firmware_frame_duration_);
+	// In units of 1.25 ms, between the 7.5 ms minimum and 100 ms
+	uint16_t interval_ms = latency_budget_ms_ > 0 ?
+		latency_budget_ms_ / 4 : firmware_frame_duration_;
+	conn_interval_ = constrain(interval_ms * 4 / 5, 6, 80);
+	hold_ms_ = latency_budget_ms_ - min(latency_budget_ms_, conn_interval_ * 5 / 4);
+	requestConnectionInterval();
+}
+
+uint16_t NeosensoryBluefruit::latency_budget(void) {
+	return latency_budget_ms_;
+}
+
+/** @brief Asks the wristband for the connection interval set by setLatencyBudget()
+ */
+void NeosensoryBluefruit::requestConnectionInterval(void) {
+	if (conn_interval_ == 0 || conn_handle_ == BLE_CONN_HANDLE_INVALID) {
+		return;
+	}
+	BLEConnection* conn = Bluefruit.Connection(conn_handle_);
+	if (conn != NULL) {
+		conn->requestConnectionParameter(conn_interval_);
+	}
+}
+
+/** @brief Adds a frame to the held frames, in the slot of the firmware frame it was
+ *	requested in
+ *	@note Slots skipped since the last held frame repeat it, so the frames play with
+ *	the spacing they were requested at. A frame requested in the same slot as the last
+ *	one replaces it.
+ *	@return False if the frame repeats the last one and was not held
+ */
+bool NeosensoryBluefruit::holdFrame(uint8_t motor_intensities[]) {
+	uint32_t now = millis();
+	if (held_count_ > 0 &&
+		(now - held_start_ms_) / firmware_frame_duration_ >= max_frames_per_bt_package_) {
+		flushHeldFrames();
+	}
+	uint8_t* last = held_count_ > 0 ?
+		held_frames_ + (held_count_ - 1) * num_motors_ : previous_motor_array_;
+	if (compareArrays(motor_intensities, last, num_motors_)) {
+		// The wristband keeps playing the last frame it was sent
+		return false;
+	}
+	if (held_count_ == 0) {
+		held_start_ms_ = now;
+	}
+	size_t slot = (now - held_start_ms_) / firmware_frame_duration_;
+	for (size_t i = held_count_; i < slot; i++) {
+		memcpy(held_frames_ + i * num_motors_, last, sizeof(uint8_t) * num_motors_);
+	}
+	memcpy(held_frames_ + slot * num_motors_, motor_intensities, sizeof(uint8_t) * num_motors_);
+	held_count_ = slot + 1;
+	return true;
+}
+
+/** @brief Sends the held frames in one packet
+ */
+void NeosensoryBluefruit::flushHeldFrames(void) {
+	if (held_count_ == 0) {
+		return;
+	}
+	sendMotorCommand(held_frames_, held_count_);
+	if (held_sparse_) {
+		sparse_stats_.packets++;
+	}
+	held_count_ = 0;
+	held_sparse_ = false;
+}
+
+void NeosensoryBluefruit::dropHeldFrames(void) {
+	held_count_ = 0;
+	held_sparse_ = false;
+}
+
+/** @brief Sends the held frames once the oldest has waited out the latency
+ *	budget, less the connection interval it may still wait for
+ */
+void NeosensoryBluefruit::updateHeldFrames(void) {
+	if (held_count_ > 0 && millis() - held_start_ms_ >= hold_ms_) {
+		flushHeldFrames();
+	}
+}
+
+NeoLinkStats NeosensoryBluefruit::getLinkStats(void) {
+	NeoLinkStats stats = link_stats_;
+	stats.elapsed_ms = millis() - link_stats_since_ms_;
+	stats.packets_per_second = stats.elapsed_ms > 0 ?
+		stats.packets * 1000.0f / stats.elapsed_ms : 0;
+	return stats;
+}
+
+void NeosensoryBluefruit::resetLinkStats(void) {
+	memset(&link_stats_, 0, sizeof(link_stats_));
+	link_stats_since_ms_ = millis();
+}
+
+#if NEO_ENABLE_LEDS
 /* LEDS */
 void NeosensoryBluefruit::setLeds(char *colorVals[],int intensities[])
 {
+    leds_animating_ = false;
+    led_command_len_ = 0;
+    // Held as solid animations, so update() can send the state again after a reconnect
+    for (int i = 0; i < NEO_NUM_LEDS; i++) {
+        memset(&led_animations_[i], 0, sizeof(NeoLedAnimation));
+        led_animations_[i].effect = NEO_LED_SOLID;
+        led_animations_[i].color = strtoul(colorVals[i], NULL, 16) & 0xFFFFFF;
+        led_animations_[i].intensity = constrain(intensities[i], 0, NEO_LED_MAX_INTENSITY);
+        led_sent_colors_[i] = led_animations_[i].color;
+        led_sent_intensities_[i] = led_animations_[i].intensity;
+    }
+    char command[NEO_LED_COMMAND_SIZE * 2];
+    snprintf(command, sizeof(command), "leds set %s %s %s %u %u %u\n",
+        colorVals[0], colorVals[1], colorVals[2], led_animations_[0].intensity,
+        led_animations_[1].intensity, led_animations_[2].intensity);
+    leds_known_ = true;
+    leds_synced_ = true;
+    led_sent_ms_ = millis();
+    link_stats_.led_bytes += strlen(command);
+    link_stats_.led_updates++;
+    sendCommand(command);
+}
 
-    static char color_vals[64];
-    sprintf(color_vals, "%s %s %s", colorVals[0],colorVals[1],colorVals[2]);
-    char intensity_vals[64];
-    sprintf(intensity_vals,"%d %d %d", intensities[0],intensities[1],intensities[2]);
-    sendCommand("leds set ");
-    sendCommand(color_vals);
-    sendCommand(" ");
-    sendCommand(intensity_vals);
-    sendCommand("\n");
+void NeosensoryBluefruit::setLedAnimation(uint8_t led, const NeoLedAnimation& animation)
+{
+    if (led >= NEO_NUM_LEDS) {
+        return;
+    }
+    uint32_t now = millis();
+    if (!leds_known_) {
+        // Every leds set command sets all LEDs, so ones never set are turned off
+        for (int i = 0; i < NEO_NUM_LEDS; i++) {
+            memset(&led_animations_[i], 0, sizeof(NeoLedAnimation));
+            led_animations_[i].effect = NEO_LED_SOLID;
+        }
+        leds_known_ = true;
+    }
+    leds_animating_ = true;
+    led_from_intensities_[led] = ledIntensityAt(led, now);
+    led_animations_[led] = animation;
+    led_animations_[led].intensity = min(animation.intensity, NEO_LED_MAX_INTENSITY);
+    led_start_ms_[led] = now;
+}
+
+void NeosensoryBluefruit::fadeLed(
+    uint8_t led, uint32_t color, uint8_t intensity, uint16_t duration_ms)
+{
+    NeoLedAnimation animation = {NEO_LED_FADE, color, intensity, duration_ms, 0};
+    setLedAnimation(led, animation);
+}
+
+void NeosensoryBluefruit::blinkLed(
+    uint8_t led, uint32_t color, uint8_t intensity, uint16_t period_ms)
+{
+    NeoLedAnimation animation = {NEO_LED_BLINK, color, intensity, period_ms, 0};
+    setLedAnimation(led, animation);
+}
+
+void NeosensoryBluefruit::followMotorLed(
+    uint8_t led, uint32_t color, uint8_t motor, uint8_t intensity)
+{
+    NeoLedAnimation animation = {NEO_LED_FOLLOW_MOTOR, color, intensity, 0, motor};
+    setLedAnimation(led, animation);
+}
+
+void NeosensoryBluefruit::stopLedAnimations(void)
+{
+    if (!leds_animating_) {
+        return;
+    }
+    // Hold each LED in the last state sent
+    for (int i = 0; i < NEO_NUM_LEDS; i++) {
+        memset(&led_animations_[i], 0, sizeof(NeoLedAnimation));
+        led_animations_[i].effect = NEO_LED_SOLID;
+        led_animations_[i].color = led_sent_colors_[i];
+        led_animations_[i].intensity = led_sent_intensities_[i];
+    }
+    leds_animating_ = false;
+}
+
+/** @brief Gets the intensity an LED's animation has at a point in time
+ */
+uint8_t NeosensoryBluefruit::ledIntensityAt(uint8_t led, uint32_t now)
+{
+    const NeoLedAnimation& animation = led_animations_[led];
+    uint32_t elapsed = now - led_start_ms_[led];
+    switch (animation.effect) {
+        case NEO_LED_FADE: {
+            if (elapsed >= animation.period_ms) {
+                return animation.intensity;
+            }
+            int from = led_from_intensities_[led];
+            return from + ((int)animation.intensity - from) * (int32_t)elapsed /
+                (int32_t)animation.period_ms;
+        }
+        case NEO_LED_BLINK:
+            if (animation.period_ms < 2) {
+                return animation.intensity;
+            }
+            return elapsed % animation.period_ms < animation.period_ms / 2u ?
+                animation.intensity : 0;
+        case NEO_LED_FOLLOW_MOTOR:
+            if (animation.motor >= num_motors_) {
+                return 0;
+            }
+            return (previous_motor_array_[animation.motor] * animation.intensity + 127) / 255;
+        default:
+            return animation.intensity;
+    }
+}
+
+/** @brief Stages the current state of the LED animations if it visibly differs
+ *	from the last state staged, or if the wristband reconnected since, and sends it
+ *	once it has waited NEO_LED_PIGGYBACK_MS for a motor packet to share a write with
+ */
+void NeosensoryBluefruit::updateLeds(void)
+{
+    uint32_t now = millis();
+    if (led_command_len_ > 0) {
+        if (now - led_pending_since_ms_ >= NEO_LED_PIGGYBACK_MS) {
+            sendLedCommand();
+        }
+        return;
+    }
+    if (!leds_known_ || (leds_synced_ && !leds_animating_) ||
+        now - led_sent_ms_ < NEO_LED_MIN_INTERVAL_MS) {
+        return;
+    }
+    if (stageLeds(now, false) && NEO_LED_PIGGYBACK_MS == 0) {
+        sendLedCommand();
+    }
+}
+
+/** @brief Formats the current state of the LED animations into led_command_
+ *	@param[in] now Current time
+ *	@param[in] force Stage the state even if it looks the same as the last state staged
+ *	@return True if a command was staged
+ */
+bool NeosensoryBluefruit::stageLeds(uint32_t now, bool force)
+{
+    uint32_t colors[NEO_NUM_LEDS];
+    uint8_t intensities[NEO_NUM_LEDS];
+    bool changed = force || !leds_synced_;
+    for (int i = 0; i < NEO_NUM_LEDS; i++) {
+        colors[i] = led_animations_[i].color & 0xFFFFFF;
+        intensities[i] = ledIntensityAt(i, now);
+        // The color of an LED that is off cannot be seen
+        changed = changed || intensities[i] != led_sent_intensities_[i] ||
+            (intensities[i] > 0 && colors[i] != led_sent_colors_[i]);
+    }
+    if (!changed) {
+        return false;
+    }
+    size_t length = snprintf(led_command_, sizeof(led_command_),
+        "leds set 0x%06lX 0x%06lX 0x%06lX %u %u %u\n",
+        (unsigned long)colors[0], (unsigned long)colors[1], (unsigned long)colors[2],
+        intensities[0], intensities[1], intensities[2]);
+    memcpy(led_sent_colors_, colors, sizeof(colors));
+    memcpy(led_sent_intensities_, intensities, sizeof(intensities));
+    leds_synced_ = true;
+    if (led_command_len_ == 0) {
+        led_pending_since_ms_ = now;
+    }
+    led_command_len_ = length;
+    return true;
+}
+
+/** @brief Sends the staged LED command on its own
+ */
+void NeosensoryBluefruit::sendLedCommand(void)
+{
+    link_stats_.led_bytes += led_command_len_;
+    link_stats_.led_updates++;
+    led_command_len_ = 0;
+    led_sent_ms_ = millis();
+    sendCommand(led_command_);
 }
 
 void NeosensoryBluefruit::getLeds()
@@ -410,21 +1440,26 @@ void NeosensoryBluefruit::getLeds()
     sendCommand("leds get");
     sendCommand("\n");
 }
+#endif
 
+#if NEO_ENABLE_BUTTONS
 /* Buttons */
 void NeosensoryBluefruit::setButtonResponse(int enable, int allowSensitivity){
 
 
-    static char args[5*sizeof(char)];
-    sprintf(args, " %d %d ", enable, allowSensitivity);
+    char args[32];
+    snprintf(args, sizeof(args), " %d %d ", enable, allowSensitivity);
     sendCommand("config set_buttons_response ");
      sendCommand(args);
     sendCommand("\n");
 }
+#endif
+
+#if NEO_ENABLE_LRA
 /* LRA Mode */
 void NeosensoryBluefruit::setLRAMode( int mode ){
-    static char args[2*sizeof(char)];
-    sprintf(args, " %d ", mode);
+    char args[16];
+    snprintf(args, sizeof(args), " %d ", mode);
     sendCommand("motors config_lra_mode");
     sendCommand(args);
     sendCommand("\n");
@@ -434,7 +1469,9 @@ void NeosensoryBluefruit::getLRAMode(){
     sendCommand("motors get_lra_mode");
     sendCommand("\n");
 }
+#endif
 
+#if NEO_ENABLE_THRESHOLDS
 /* Motor thresholds */
 void NeosensoryBluefruit::getMotorThreshold(){
     sendCommand("motors get_threshold");
@@ -443,15 +1480,16 @@ void NeosensoryBluefruit::getMotorThreshold(){
 void NeosensoryBluefruit::setMotorThreshold( int feedbackType, int threshold){
 
 
-        static char args[5*sizeof(char)];
-        sprintf(args, " %d %d ", feedbackType, threshold);
+        char args[32];
+        snprintf(args, sizeof(args), " %d %d ", feedbackType, threshold);
         sendCommand("motors config_threshold  ");
          sendCommand(args);
         sendCommand("\n");
 
 }
+#endif
 
-String NeosensoryBluefruit::getJson()
+const char* NeosensoryBluefruit::getJson()
 {
     return jsonMessage_;
 }
@@ -459,33 +1497,65 @@ String NeosensoryBluefruit::getJson()
 
 void NeosensoryBluefruit::scanCallback(ble_gap_evt_adv_report_t* report)
 {
-	if (checkDevice(report)) {
-		Bluefruit.Central.connect(report);
-	} else {
-		Bluefruit.Scanner.resume();
+	uint8_t priority;
+	if (checkDevice(report, &priority)) {
+		if (priority_window_ms_ == 0 || priority >= device_list_.max_priority()) {
+			has_candidate_ = false;
+			Bluefruit.Central.connect(report);
+			return;
+		}
+		// Remember the best device found so far, in case no higher
+		// priority device shows up within priority_window_ms_
+		if (!has_candidate_) {
+			has_candidate_ = true;
+			candidate_since_ms_ = millis();
+			candidate_priority_ = priority;
+			candidate_address_ = report->peer_addr;
+		} else if (priority > candidate_priority_) {
+			candidate_priority_ = priority;
+			candidate_address_ = report->peer_addr;
+		}
 	}
+	if (has_candidate_ && millis() - candidate_since_ms_ >= priority_window_ms_) {
+		has_candidate_ = false;
+		if (device_list_.contains(candidate_address_.addr)) {
+			Bluefruit.Central.connect(&candidate_address_);
+			return;
+		}
+	}
+	Bluefruit.Scanner.resume();
 }
 
 void NeosensoryBluefruit::connectCallback(uint16_t conn_handle)
 {
-if ( !conn->bonded() )
-  {
-    conn->requestPairing();
-		  
-  }
+	BLEConnection* conn = Bluefruit.Connection(conn_handle);
+	if (!conn->bonded()) {
+		conn->requestPairing();
+	}
 	bool success = true;
 	if (!wb_service_.discover(conn_handle) ||
 		!wb_write_characteristic_.discover() ||
 		!wb_read_characteristic_.discover() ||
-		!wb_read_characteristic_.enableNotify()||
-		//!Bluefruit.requestPairing(conn_handle) ||
-		//!Bluefruit.connPaired(conn_handle)
+		!wb_read_characteristic_.enableNotify() ||
 		!conn->bonded()
-	)
+	) {
 		Bluefruit.disconnect(conn_handle);
 		success = false;
 	}
-
+	conn_handle_ = success ? conn_handle : BLE_CONN_HANDLE_INVALID;
+#if NEO_ENABLE_LEDS
+	// The wristband's LEDs may no longer match the last state sent
+	leds_synced_ = false;
+	led_command_len_ = 0;
+#endif
+	requestConnectionInterval();
+	dropHeldFrames();
+	resetQueueModel();
+
+	NeoEvent event;
+	event.type = NEO_EVENT_CONNECTED;
+	event.connected.success = success;
+	publishEvent(event);
 	if (externalConnectedCallback) {
 		externalConnectedCallback(success);
 	}
@@ -494,26 +1564,33 @@ if ( !conn->bonded() )
 void NeosensoryBluefruit::disconnectCallback(
 	uint16_t conn_handle, uint8_t reason) {
 	is_authorized_ = false;
-	externalDisconnectedCallback(conn_handle, reason);
+	conn_handle_ = BLE_CONN_HANDLE_INVALID;
+	dropHeldFrames();
+	resetQueueModel();
+#if NEO_ENABLE_BUTTONS
+	button_gestures_.reset();
+#endif
+	NeoEvent event;
+	event.type = NEO_EVENT_DISCONNECTED;
+	event.disconnected.conn_handle = conn_handle;
+	event.disconnected.reason = reason;
+	publishEvent(event);
+	if (externalDisconnectedCallback) {
+		externalDisconnectedCallback(conn_handle, reason);
+	}
 }
 
 void NeosensoryBluefruit::readNotifyCallback(
 	BLEClientCharacteristic* chr, uint8_t* data, uint16_t len) {
 	parseCliData(data, len);
-	externalReadNotifyCallback(chr, data, len);
-    if(jsonMessage_.indexOf("button")!=-1)
-    {
-
-        if(externalButtonPressCallback)
-        {
-            String buttonVal = "button_val";
-            int position = jsonMessage_.indexOf(buttonVal);
-
-            char b = jsonMessage_[position +buttonVal.length() + 3 ];
-             int buttonID = b-'0';
-            externalButtonPressCallback(buttonID);
-        }
-        jsonMessage_ = "";
+	NeoEvent event;
+	event.type = NEO_EVENT_NOTIFY;
+	event.notify.data = data;
+	event.notify.len = len;
+	publishEvent(event);
+	if (externalReadNotifyCallback) {
+		externalReadNotifyCallback(chr, data, len);
+	}
 }
 
 void NeosensoryBluefruit::setConnectedCallback(
@@ -530,10 +1607,12 @@ void NeosensoryBluefruit::setReadNotifyCallback(
 	ReadNotifyCallback readNotifyCallback) {
 	externalReadNotifyCallback = readNotifyCallback;
 }
+#if NEO_ENABLE_BUTTONS
 void NeosensoryBluefruit::setButtonPressCallback(ButtonPressCallback buttonPressCallback)
 {
     externalButtonPressCallback = buttonPressCallback;
 }
+#endif
 /* Callback Wrappers */
 NeosensoryBluefruit* NeosensoryBluefruit::NeoBluefruit = 0;
 
@@ -30,6 +30,106 @@
 
 #include "Arduino.h"
 #include <bluefruit.h>
+#include "neosensory_address_set.h"
+#include "neosensory_bluefruit_config.h"
+#include "neosensory_event_bus.h"
+#include "neosensory_haptic_track.h"
+
+#define NEO_CALIBRATION_HEADER_SIZE 4 /**< Bytes of header in serialized calibration. */
+#define NEO_CALIBRATION_MOTOR_SIZE (6 + 2 * NEO_CURVE_MAX_POINTS) /**< Bytes per motor in serialized calibration. */
+#define NEO_MAX_PACKET_MOTOR_BYTES 171 /**< Most motor intensities sent in a single motors vibrate packet. */
+#define NEO_NUM_LEDS 3 /**< Number of LEDs on the wristband. */
+#define NEO_LED_MAX_INTENSITY 50 /**< LED intensity at full glow. */
+#define NEO_LED_COMMAND_SIZE 64 /**< Bytes in the buffer of a leds set command. */
+
+/** @brief How the device list restricts which devices NeosensoryBluefruit connects to.
+ */
+enum NeoDeviceListMode {
+    NEO_DEVICE_LIST_ALLOW = 0, /**< Only connect to devices in the list, or any Neosensory device if the list is empty. The default. */
+    NEO_DEVICE_LIST_DENY = 1 /**< Connect to any Neosensory device that is not in the list. */
+};
+
+/** @brief Curves that map linear intensities onto a motor's vibration range.
+ */
+enum NeoCurveType {
+    NEO_CURVE_EXPONENTIAL = 0, /**< Exponential curve that feels linear on the skin. The default. */
+    NEO_CURVE_GAMMA = 1, /**< Power curve, input raised to the calibration's gamma. */
+    NEO_CURVE_PIECEWISE = 2 /**< Piecewise linear curve through user-supplied points. */
+};
+
+/** @brief Calibration of a single motor.
+ *  @note Set with NeosensoryBluefruit::setMotorCalibration(), which compiles it into
+ *  a lookup table so that converting intensities stays a table lookup per value.
+ */
+struct NeoMotorCalibration {
+    uint8_t min_vibration; /**< Motor intensity for the smallest non-zero input, between 0 and 255. */
+    uint8_t max_vibration; /**< Motor intensity for an input of 1, between 0 and 255. */
+    uint8_t curve; /**< A NeoCurveType. */
+    float gamma; /**< Exponent for NEO_CURVE_GAMMA. Ignored by other curves. */
+    uint8_t num_points; /**< Number of points used in points_in and points_out, up to NEO_CURVE_MAX_POINTS. */
+    uint8_t points_in[NEO_CURVE_MAX_POINTS]; /**< Increasing inputs of NEO_CURVE_PIECEWISE, where 0 to 255 spans 0 to 1. */
+    uint8_t points_out[NEO_CURVE_MAX_POINTS]; /**< Outputs of NEO_CURVE_PIECEWISE, where 0 to 255 spans min_vibration to max_vibration. */
+};
+
+/** @brief Counters of how sparse motor updates were coalesced into packets.
+ */
+struct NeoSparseStats {
+    uint32_t updates; /**< Number of motor values set with setMotor() or setMotors(). */
+    uint32_t flushes; /**< Number of coalesced frames flushed, each in at most one packet. */
+    uint32_t packets; /**< Number of motor packets sent that carried flushed frames. */
+    uint16_t last_merged; /**< Number of motor values merged into the last flushed frame. */
+    uint16_t max_merged; /**< Most motor values merged into a single flushed frame. */
+};
+
+/** @brief Counters of the traffic sent to the wristband, to weigh radio cost against latency.
+ */
+struct NeoLinkStats {
+    uint32_t writes; /**< Number of writes to the write characteristic. */
+    uint32_t packets; /**< Estimated number of radio packets the writes took. */
+    uint32_t bytes; /**< Number of bytes written. */
+    uint32_t radio_on_us; /**< Estimated time the radio was on to send the packets, in microseconds. */
+    uint32_t led_bytes; /**< Bytes of the writes that were LED commands. */
+    uint32_t led_updates; /**< Number of LED commands sent. */
+    uint32_t led_piggybacked; /**< Number of LED commands sent in the same write as a motor packet. */
+    uint32_t elapsed_ms; /**< Milliseconds since the counters were reset. */
+    float packets_per_second; /**< Average packets sent per second since the counters were reset. */
+};
+
+#if NEO_ENABLE_LEDS
+/** @brief Effects an LED animation can play.
+ */
+enum NeoLedEffect {
+    NEO_LED_SOLID = 0, /**< Holds intensity. */
+    NEO_LED_FADE = 1, /**< Fades from the LED's intensity when the animation starts to intensity, over period_ms. */
+    NEO_LED_BLINK = 2, /**< On at intensity for the first half of every period_ms, off for the second half. */
+    NEO_LED_FOLLOW_MOTOR = 3 /**< Ramps with the last intensity sent to motor, reaching intensity when it vibrates at 255. */
+};
+
+/** @brief Animation of a single wristband LED.
+ *  @note Set with NeosensoryBluefruit::setLedAnimation() and played by update().
+ */
+struct NeoLedAnimation {
+    uint8_t effect; /**< A NeoLedEffect. */
+    uint32_t color; /**< Color as 0xRRGGBB. */
+    uint8_t intensity; /**< Intensity the effect reaches, between 0 and NEO_LED_MAX_INTENSITY. */
+    uint16_t period_ms; /**< Duration of a fade, or period of a blink. Ignored by other effects. */
+    uint8_t motor; /**< Index of the motor NEO_LED_FOLLOW_MOTOR follows. Ignored by other effects. */
+};
+#endif
+
+#if NEO_BOUNDED_RAM
+/** @brief Fixed buffers that replace the heap allocations when NEO_BOUNDED_RAM is set.
+ *  @note Held by NeosensoryBluefruit, so sizeof(NeoBoundedStorage) is the RAM
+ *  these buffers add to the object.
+ */
+struct NeoBoundedStorage {
+    NeoMotorCalibration motor_calibrations[NEO_MAX_MOTORS]; /**< Calibration of each motor. */
+    uint8_t motor_tables[NEO_MAX_MOTORS * NEO_CALIBRATION_TABLE_SIZE]; /**< Lookup table of each motor. */
+    uint8_t previous_motors[NEO_MAX_MOTORS]; /**< Last intensity sent to each motor. */
+    uint8_t stream_motors[NEO_MAX_MOTORS]; /**< Latest frame of the stream lane. */
+    uint8_t held_frames[NEO_MAX_PACKET_MOTOR_BYTES]; /**< Frames held back to share a packet. */
+};
+#endif
 
 /** @brief Class that handles connecting to and communicating with a Neosensory device over BLE. 
  *  Relies heavily on Adafruit's Bluefruit library for BLE. Opens all developer accessible
@@ -40,12 +140,15 @@ class NeosensoryBluefruit
     typedef void (*ConnectedCallback)(bool); 
     typedef void (*DisconnectedCallback)(uint16_t, uint8_t); 
     typedef void (*ReadNotifyCallback)(BLEClientCharacteristic*, uint8_t*, uint16_t);
+#if NEO_ENABLE_BUTTONS
     typedef void (*ButtonPressCallback)(int);
+#endif
 
   public:
     /** @brief Constructor for new NeosensoryBluefruit object
      *  @param[in] device_id The device_id of the hardware to connect to. Leave blank to connect to any Neosensory device.
      *  @param[in] num_motors The number of vibrating motors this device has.
+     *  At most NEO_MAX_MOTORS if NEO_BOUNDED_RAM is set.
      *  @param[in] initial_min_vibration The mininum vibration intensity, between 0 and 255. Should be less than initial_max_vibration.
      *  @param[in] initial_max_vibration The maximum vibration intensity, between 0 and 255. Should be greater than initial_min_vibration.
      */
@@ -66,7 +169,8 @@ class NeosensoryBluefruit
     bool startScan(void);
 
     /** @brief Get address of device to connect to
-     *  @return Byte array of address to connect to, or 0 if not set.
+     *  @return Byte array of the address most recently set with setDeviceId() or
+     *  addDeviceId(), or 0 if NeosensoryBluefruit will connect to any Neosensory device.
      */
     uint8_t* getDeviceAddress(void);
     
@@ -82,6 +186,43 @@ class NeosensoryBluefruit
      */
     void setDeviceId(char new_device_id[]);
 
+    /** @brief Adds a device ID to the device list, or updates its priority.
+     *  @param[in] device_id Device ID to add, formatted as for setDeviceId().
+     *  @param[in] priority Priority of the device. Higher is preferred, see setPriorityWindow().
+     *  @return True if the device is in the list, false if the list is full or device_id is empty.
+     *  @note Takes effect immediately, including during a running scan. The list holds up to
+     *  3/4 of NEO_ADDRESS_SET_CAPACITY devices.
+     */
+    bool addDeviceId(char device_id[], uint8_t priority=0);
+
+    /** @brief Removes a device ID from the device list.
+     *  @param[in] device_id Device ID to remove, formatted as for setDeviceId().
+     *  @return True if the device was in the list.
+     *  @note Takes effect immediately, including during a running scan. The list is
+     *  updated in a critical section, so a scan report in DENY mode never misses a
+     *  device that is still denied.
+     */
+    bool removeDeviceId(char device_id[]);
+
+    /** @brief Removes all device IDs from the device list.
+     */
+    void clearDeviceIds(void);
+
+    /** @brief Sets whether the device list holds the only devices to connect to,
+     *  or devices never to connect to.
+     *  @param[in] mode NEO_DEVICE_LIST_ALLOW or NEO_DEVICE_LIST_DENY.
+     */
+    void setDeviceListMode(NeoDeviceListMode mode);
+
+    /** @brief Sets how long to wait for a higher priority device when a lower
+     *  priority one in the device list is found during a scan.
+     *  @param[in] window_ms Milliseconds to wait. When 0, the default, the first
+     *  device found that is in the list is connected to.
+     *  @note A device with the highest priority in the list is always connected to
+     *  immediately.
+     */
+    void setPriorityWindow(uint16_t window_ms);
+
 
     /* Developer Commands */
 
@@ -193,6 +334,40 @@ class NeosensoryBluefruit
      */
     void setReadNotifyCallback(ReadNotifyCallback);
 
+#if NEO_ENABLE_BUTTONS
+    /** @brief Sets a callback that gets called when a wristband button is pressed
+     *  @param[in] buttonPressCallback The function to call. Takes the id of the button pressed.
+     *  @note Button responses must be enabled with setButtonResponse(). Called once per
+     *  debounced press. Subscribe to NEO_EVENT_BUTTON for double and long presses.
+     */
+    void setButtonPressCallback(ButtonPressCallback);
+#endif
+
+    /** @brief Subscribe a handler to a type of event, alongside any other handlers of that type.
+     *  @param[in] type Type of event to handle, e.g. NEO_EVENT_BUTTON.
+     *  @param[in] handler Function to call with each event of that type.
+     *  @param[in] context Pointer passed to handler.
+     *  @return True if subscribed, false if the type already has NEO_MAX_SUBSCRIBERS handlers.
+     *  @note Each CLI JSON message is parsed once when it completes, and its events are
+     *  published only to the handlers of their type. Button gestures need button
+     *  responses enabled with setButtonResponse().
+     */
+    bool subscribe(NeoEventType type, NeoEventHandler handler, void* context=NULL);
+
+    /** @brief Unsubscribe a handler from a type of event.
+     *  @param[in] type Type of event the handler was subscribed to.
+     *  @param[in] handler The handler.
+     *  @param[in] context The context the handler was subscribed with.
+     *  @return True if the handler was subscribed.
+     */
+    bool unsubscribe(NeoEventType type, NeoEventHandler handler, void* context=NULL);
+
+    /** @brief Get the most recent CLI JSON message received from the wristband.
+     *  @return The last JSON message, or the part of it received so far.
+     *  @note Messages longer than NEO_JSON_BUFFER_SIZE are discarded.
+     */
+    const char* getJson(void);
+
 
     /* Vibration */
 
@@ -209,9 +384,39 @@ class NeosensoryBluefruit
      */
     uint8_t max_frames_per_bt_package(void);
 
-    uint8_t max_vibration; /**< Maximum vibration intensity, between 0 and 255. */
+    /** @brief Get the estimated number of motor frames buffered on the device.
+     *  @return Number of frames sent to the device that have not finished playing.
+     *  @note This is a model, not a readout from the device. It assumes every frame
+     *  sent plays for firmware_frame_duration milliseconds, back to back. It is
+     *  reset by motorsClearQueue(), motorsStop() and on connect or disconnect.
+     */
+    uint16_t framesQueued(void);
+
+    /** @brief Check if the device queue has room for more frames.
+     *  @param[in] num_frames The number of frames the caller wants to send.
+     *  @return True if sending num_frames now would keep framesQueued() at or
+     *  below max_frames_queued().
+     *  @note Use this to generate frames just in time rather than overfilling
+     *  the device queue, which only adds latency.
+     */
+    bool canAccept(size_t num_frames=1);
+
+    /** @brief Get the maximum number of frames canAccept() allows to be queued.
+     *  @return Max frames allowed in the device queue. Defaults to one and a half
+     *  times max_frames_per_bt_package(), so that the next full packet can be sent
+     *  while half a packet is still playing and the motors never run dry.
+     */
+    uint16_t max_frames_queued(void);
+
+    /** @brief Set the maximum number of frames canAccept() allows to be queued.
+     *  @param[in] max_frames Max frames to allow in the device queue. Higher values
+     *  are more tolerant of a late producer but add latency.
+     */
+    void setMaxFramesQueued(uint16_t max_frames);
+
+    uint8_t max_vibration; /**< Maximum vibration intensity, between 0 and 255. Changing it applies to all motors. */
 
-    uint8_t min_vibration; /**< Minimum vibration intensity, between 0 and 255. */
+    uint8_t min_vibration; /**< Minimum vibration intensity, between 0 and 255. Changing it applies to all motors. */
 
     /** @brief Get number of motors
      *  @return The number of motors this instance of NeosensoryBluetooth 
@@ -226,9 +431,40 @@ class NeosensoryBluefruit
     /** @brief Turn on a single motor at an intensity
      *  @param[in] motor Index of motor to vibrate
      *  @param[in] intensity Intensity to vibrate motor at, between 0 and 1
+     *  @note Turns every other motor off. Use setMotor() to leave them as they are.
      */
     void vibrateMotor(uint8_t motor, float intensity);
 
+    /** @brief Set the intensity of a single motor, leaving the other motors as they are.
+     *  @param[in] motor Index of motor to set
+     *  @param[in] intensity Intensity to vibrate motor at, between 0 and 1
+     *  @note Updates are merged into one frame, which update() sends at most once per
+     *  firmware_frame_duration as a single packet. Call flushMotors() to send it sooner.
+     */
+    void setMotor(uint8_t motor, float intensity);
+
+    /** @brief Set the intensities of several motors, leaving the other motors as they are.
+     *  @param[in] motors Array of indices of the motors to set
+     *  @param[in] intensities Array of intensities, between 0 and 1, one for each index in motors
+     *  @param[in] count Number of motors to set
+     *  @note Coalesced with other updates like setMotor().
+     */
+    void setMotors(const uint8_t motors[], const float intensities[], size_t count);
+
+    /** @brief Send the frame of pending setMotor() and setMotors() updates now.
+     *  @note Does nothing if there are no pending updates, and defers them while an alert plays.
+     */
+    void flushMotors(void);
+
+    /** @brief Get counters of how setMotor() and setMotors() calls were coalesced.
+     *  @return Counters since the last resetSparseStats().
+     */
+    NeoSparseStats getSparseStats(void);
+
+    /** @brief Reset the counters returned by getSparseStats().
+     */
+    void resetSparseStats(void);
+
     /** @brief Cause the wristband to vibrate at the given intensities, for multiple frames
      *  @param[in] intensities A nested array of float values that denote the linear
      *  intensity values, between 0 and 1. Each index in the inner arrays corresponds
@@ -253,24 +489,206 @@ class NeosensoryBluefruit
      *  to the new array of intensities.
      */
     void vibrateMotors(float intensities[]);
-    
+
+    /** @brief Play an alert that cuts ahead of everything else queued for the motors.
+     *  @param[in] intensities A nested array of linear intensities, one frame per outer
+     *  index, as for vibrateMotors(float *intensities[], int num_frames).
+     *  @param[in] num_frames The number of frames. Cannot be more than max_frames_per_bt_package_.
+     *  @param[in] priority Priority of the alert, at least 1. Streamed output (vibrateMotors()
+     *  and tracks) has priority 0.
+     *  @return True if the alert was sent, false if num_frames is 0 or a higher priority
+     *  alert is playing.
+     *  @note Clears the device motor queue so the alert plays immediately. Until the alert
+     *  has played, vibrateMotors() frames are dropped as stale, except that the last
+     *  single frame requested is sent once the alert ends. A playing track resumes at the
+     *  frame its timeline has reached, skipping the frames the alert replaced.
+     *  Frames of a multi-frame vibrateMotors() stream that were queued when the alert
+     *  started are lost, not resumed; alertFramesDiscarded() tells how many.
+     */
+    bool playAlert(float *intensities[], int num_frames, uint8_t priority=1);
+
+    /** @brief Get the number of frames the last alert discarded.
+     *  @return Frames that were queued on the device or held for the latency budget
+     *  when the last playAlert() cleared the queue, by the framesQueued() model.
+     *  @note A sender of a stream can resend or skip this many frames of its own
+     *  timeline to pick up where the alert cut in.
+     */
+    uint16_t alertFramesDiscarded(void);
+
+    /** @brief Check if an alert is playing.
+     *  @return True if frames sent by playAlert() are still playing.
+     */
+    bool isPlayingAlert(void);
+
+    /** @brief Services timed output, such as streaming a track, animating LEDs and
+     *  publishing long presses of held buttons.
+     *  @note Call this from loop() as often as possible.
+     */
+    void update(void);
+
+
+    /* Link */
+
+    /** @brief Trade latency for fewer radio packets when streaming single frames.
+     *  @param[in] budget_ms Most milliseconds a frame may wait before it is sent, e.g. 64 to 200.
+     *  0, the default, sends every frame as soon as it is requested. Clamped to the
+     *  duration of a full packet of frames.
+     *  @note Frames from vibrateMotors(float intensities[]) and setMotor() are held on a
+     *  timeline of firmware frames and sent together from update(), so they play with
+     *  their original spacing, delayed by the budget. Also requests a connection interval
+     *  of a quarter of the budget, so the radio wakes less often; the interval counts
+     *  against the budget. Setting 0 requests an interval of one firmware frame.
+     */
+    void setLatencyBudget(uint16_t budget_ms);
+
+    /** @brief Get the latency budget.
+     *  @return Latency budget in milliseconds, or 0 if frames are sent immediately.
+     */
+    uint16_t latency_budget(void);
+
+    /** @brief Get counters of the traffic sent to the wristband.
+     *  @return Counters since the last resetLinkStats().
+     *  @note Radio time is estimated from NEO_RADIO_PACKET_US and NEO_RADIO_BYTE_US,
+     *  and leaves out the empty connection events that keep the link alive.
+     */
+    NeoLinkStats getLinkStats(void);
+
+    /** @brief Reset the counters returned by getLinkStats().
+     */
+    void resetLinkStats(void);
+
+
+    /* Tracks */
+
+    /** @brief Start streaming a haptic track to the wristband.
+     *  @param[in] track Reader of the track to play. Must stay valid until the track
+     *  finishes or stopTrack() is called. Playback starts at the reader's current position.
+     *  @return True if playback started, false if the track's number of motors or frame
+     *  duration does not match this device.
+     *  @note Frames are decoded one packet at a time in update(), whenever the device
+     *  queue has room for at least half a packet, or for max_frames_queued() frames
+     *  if that is less, and sent without calibration, since
+     *  tracks hold motor intensities.
+     */
+    bool playTrack(NeosensoryTrackReader* track);
+
+    /** @brief Stop streaming the current track.
+     *  @note Frames already sent to the wristband still play. Call motorsClearQueue()
+     *  to stop them too.
+     */
+    void stopTrack(void);
+
+    /** @brief Check if a track is being streamed.
+     *  @return True if a track is playing and has frames left to send.
+     */
+    bool isPlayingTrack(void);
+
+    /* Calibration */
+
+    /** @brief Set the calibration of a single motor.
+     *  @param[in] motor Index of the motor to calibrate.
+     *  @param[in] calibration The motor's vibration range and curve.
+     *  @note Rebuilds the motor's lookup table. Changing min_vibration or
+     *  max_vibration afterwards resets the range of every motor, but keeps their curves.
+     */
+    void setMotorCalibration(uint8_t motor, const NeoMotorCalibration& calibration);
+
+    /** @brief Get the calibration of a single motor.
+     *  @param[in] motor Index of the motor.
+     *  @return The motor's current calibration.
+     */
+    NeoMotorCalibration getMotorCalibration(uint8_t motor);
+
+    /** @brief Set the vibration range of a single motor, keeping its curve.
+     *  @param[in] motor Index of the motor to calibrate.
+     *  @param[in] min_intensity Motor intensity for the smallest non-zero input, between 0 and 255.
+     *  @param[in] max_intensity Motor intensity for an input of 1, between 0 and 255.
+     */
+    void setMotorRange(uint8_t motor, uint8_t min_intensity, uint8_t max_intensity);
+
+    /** @brief Get the number of bytes needed to serialize the calibration of all motors.
+     *  @return Size of the buffer saveCalibration() needs.
+     */
+    size_t calibrationSize(void);
+
+    /** @brief Serialize the calibration of all motors, for instance to persist it in flash.
+     *  @param[out] buffer Buffer to write the calibration to.
+     *  @param[in] buffer_len Length of buffer. Must be at least calibrationSize().
+     *  @return The number of bytes written, or 0 if buffer is too small.
+     */
+    size_t saveCalibration(uint8_t buffer[], size_t buffer_len);
+
+    /** @brief Restore a calibration written by saveCalibration().
+     *  @param[in] buffer Serialized calibration.
+     *  @param[in] buffer_len Length of buffer.
+     *  @return True if the calibration was loaded, false if it is malformed or
+     *  was saved for a different number of motors.
+     */
+    bool loadCalibration(const uint8_t buffer[], size_t buffer_len);
+
+#if NEO_ENABLE_LEDS
     /* LED's */
     
     /** @brief Set the colors of the LEDs on the wristband
      *  @param[in] colorVals and array of char* that are the Hex represnetation of the
      *  color for each of the 3 LEDs in the wristband.
      *  @param[in] intensities an array of ints that are  the "brightness" of each LED
-     *  ranging from 0 ( off )  to 50 ( full glow )
-     
+     *  ranging from 0 ( off )  to NEO_LED_MAX_INTENSITY ( full glow ), clamped to that range
+     *  @note Sent as a single write. Stops any LED animations. update() sends the
+     *  same state again after the wristband reconnects.
      */
     void setLeds( char *colorVals[], int intensities[] );
+
+    /** @brief Animate a single LED, leaving the others as setLeds() or their own
+     *  animations last set them.
+     *  @param[in] led Index of the LED, below NEO_NUM_LEDS.
+     *  @param[in] animation The animation to play, starting now. Its intensity is
+     *  clamped to NEO_LED_MAX_INTENSITY, like the intensities of setLeds().
+     *  @note The wristband only takes the state of all LEDs at once, so LEDs never set
+     *  by setLeds() or an animation since startup are turned off.
+     *  update() sends the state of all LEDs only when it visibly changes, at most
+     *  once every NEO_LED_MIN_INTERVAL_MS. Each update waits up to NEO_LED_PIGGYBACK_MS
+     *  to go out in the same write as a motor packet, if both fit in one packet.
+     *  The state is sent again after the wristband reconnects.
+     */
+    void setLedAnimation(uint8_t led, const NeoLedAnimation& animation);
+
+    /** @brief Fade an LED to a color and intensity.
+     *  @param[in] led Index of the LED.
+     *  @param[in] color Color as 0xRRGGBB.
+     *  @param[in] intensity Intensity to fade to, between 0 and NEO_LED_MAX_INTENSITY.
+     *  @param[in] duration_ms Duration of the fade.
+     */
+    void fadeLed(uint8_t led, uint32_t color, uint8_t intensity, uint16_t duration_ms);
+
+    /** @brief Blink an LED.
+     *  @param[in] led Index of the LED.
+     *  @param[in] color Color as 0xRRGGBB.
+     *  @param[in] intensity Intensity while on, between 0 and NEO_LED_MAX_INTENSITY.
+     *  @param[in] period_ms Duration of one blink, on then off.
+     */
+    void blinkLed(uint8_t led, uint32_t color, uint8_t intensity, uint16_t period_ms);
+
+    /** @brief Make an LED's intensity follow a motor's.
+     *  @param[in] led Index of the LED.
+     *  @param[in] color Color as 0xRRGGBB.
+     *  @param[in] motor Index of the motor to follow.
+     *  @param[in] intensity LED intensity when the motor vibrates at 255, between 0 and NEO_LED_MAX_INTENSITY.
+     */
+    void followMotorLed(uint8_t led, uint32_t color, uint8_t motor, uint8_t intensity);
+
+    /** @brief Stop all LED animations, holding the LEDs in the last state sent.
+     */
+    void stopLedAnimations(void);
  
    /** @brief Get the current colour Vals for the LEDs on the wrist band
     *  @note You will have to monitor the notifications from the CLI to get your
     *  response.
     */
     void getLeds();
-    
+#endif
+
+#if NEO_ENABLE_BUTTONS
     /* Buttons */
     
     /** @brief Set the response behaviour of the buttons on the wrist band
@@ -283,7 +701,9 @@ class NeosensoryBluefruit
      *  the response if you enable button response
      */
     void setButtonResponse(int enable, int allowSensitivity);
-    
+#endif
+
+#if NEO_ENABLE_LRA
     /* LRA mode */
     
     /** @brief Set the behaivor of the LRA between open and closed loop
@@ -295,7 +715,9 @@ class NeosensoryBluefruit
      *  @note remeber if to look at the CLI response to access the returned data
      */
     void getLRAMode();
-    
+#endif
+
+#if NEO_ENABLE_THRESHOLDS
     /* Motor Thresholds*/
     /** @brief Set the response and behavior of the band to the motors vibrate commands
      *  @param[in] feedbackType an int that is either 0 ( default ) he motors vibrate
@@ -308,37 +730,133 @@ class NeosensoryBluefruit
     /** @brief Get the current threshold of the motors
      */
     void getMotorThreshold();
-    
+#endif
 
   private:
-    bool checkAddressMatches(uint8_t foundAddress[]);
-    bool checkDevice(ble_gap_evt_adv_report_t* report);
+    bool checkDevice(ble_gap_evt_adv_report_t* report, uint8_t* priority);
     bool checkIsNeosensory(ble_gap_evt_adv_report_t* report);
     bool connect_to_any_neo_device_;
     bool is_authorized_;
     uint8_t device_address_[BLE_GAP_ADDR_LEN];
     void setDeviceAddress(char device_id[]);
+    void updateDeviceListMode(void);
+
+    /* Device List */
+    NeosensoryAddressSet device_list_;
+    NeoDeviceListMode device_list_mode_;
+    uint16_t priority_window_ms_;
+    bool has_candidate_;
+    uint8_t candidate_priority_;
+    uint32_t candidate_since_ms_;
+    ble_gap_addr_t candidate_address_;
 
     /* Vibrations */
     uint8_t *previous_motor_array_;
+    NeoMotorCalibration *motor_calibrations_;
+    uint8_t *motor_tables_;
+    uint8_t applied_min_vibration_;
+    uint8_t applied_max_vibration_;
+#if NEO_BOUNDED_RAM
+    NeoBoundedStorage storage_;
+#endif
+    void buildMotorTable(uint8_t motor);
+    void applyGlobalVibrationRange(void);
     uint8_t firmware_frame_duration_;
     uint8_t max_frames_per_bt_package_;
     uint8_t num_motors_;
+    uint16_t frames_queued_;
+    uint16_t max_frames_queued_;
+    uint32_t queue_updated_ms_;
+    void resetQueueModel(void);
+    void updateQueueModel(void);
     void getMotorIntensitiesFromLinArray(
         float lin_array[], uint8_t motor_space_array[], size_t array_size);
     void sendMotorCommand(uint8_t motor_intensities[], size_t num_frames=1);
+    int sendLinearFrames(float *intensities[], int num_frames);
+
+    /* Priority Lanes */
+    uint8_t *stream_motor_array_;
+    bool stream_frame_pending_;
+    bool sparse_pending_;
+    uint16_t pending_motor_updates_;
+    uint32_t last_motor_flush_ms_;
+    NeoSparseStats sparse_stats_;
+    void sendStreamFrame(void);
+    void updateSparseMotors(void);
+    bool alert_active_;
+    uint8_t alert_priority_;
+    uint32_t alert_end_ms_;
+    uint16_t alert_frames_discarded_;
+    void updateAlert(void);
+
+    /* Tracks */
+    NeosensoryTrackReader* track_;
+    bool track_timed_;
+    bool track_resync_;
+    uint32_t track_start_ms_;
+    void updateTrack(void);
+
+    /* Link */
+    uint16_t conn_handle_;
+    uint16_t latency_budget_ms_;
+    uint16_t hold_ms_;
+    uint8_t conn_interval_;
+    uint16_t max_write_len_;
+    uint8_t *held_frames_;
+    uint8_t held_count_;
+    uint32_t held_start_ms_;
+    NeoLinkStats link_stats_;
+    uint32_t link_stats_since_ms_;
+    void requestConnectionInterval(void);
+    bool held_sparse_;
+    bool holdFrame(uint8_t motor_intensities[]);
+    void flushHeldFrames(void);
+    void dropHeldFrames(void);
+    void updateHeldFrames(void);
+
+#if NEO_ENABLE_LEDS
+    /* LEDs */
+    NeoLedAnimation led_animations_[NEO_NUM_LEDS];
+    uint32_t led_start_ms_[NEO_NUM_LEDS];
+    uint8_t led_from_intensities_[NEO_NUM_LEDS];
+    bool leds_known_;
+    bool leds_animating_;
+    bool leds_synced_;
+    uint32_t led_sent_colors_[NEO_NUM_LEDS];
+    uint8_t led_sent_intensities_[NEO_NUM_LEDS];
+    uint32_t led_sent_ms_;
+    char led_command_[NEO_LED_COMMAND_SIZE];
+    size_t led_command_len_;
+    uint32_t led_pending_since_ms_;
+    uint8_t ledIntensityAt(uint8_t led, uint32_t now);
+    void updateLeds(void);
+    bool stageLeds(uint32_t now, bool force);
+    void sendLedCommand(void);
+#endif
 
     /* CLI Parsing */
     bool jsonStarted_;
-    String jsonMessage_;
-    void handleCliJson(String jsonMessage);
+    char jsonMessage_[NEO_JSON_BUFFER_SIZE];
+    size_t jsonLength_;
+    void handleCliJson(const char* jsonMessage);
     void parseCliData(uint8_t* data, uint16_t len);
 
+    /* Events */
+    NeosensoryEventBus events_;
+#if NEO_ENABLE_BUTTONS
+    NeosensoryButtonGestures button_gestures_;
+    void handleButton(uint8_t button);
+    void updateButtons(void);
+#endif
+    void publishEvent(NeoEvent& event);
+
     /* External Callbacks */
     ConnectedCallback externalConnectedCallback;
     DisconnectedCallback externalDisconnectedCallback;
     ReadNotifyCallback externalReadNotifyCallback;
+#if NEO_ENABLE_BUTTONS
     ButtonPressCallback externalButtonPressCallback;
+#endif
 
     /* Services & Characteristic UUIDs */
     uint8_t wb_service_uuid_[16];
@@ -351,6 +869,17 @@ class NeosensoryBluefruit
     BLEClientCharacteristic wb_read_characteristic_;
 };
 
+#if NEO_BOUNDED_RAM
+/** @brief RAM used by a NeosensoryBluefruit object when NEO_BOUNDED_RAM is set.
+ *  @note Everything the object holds, including the NeoBoundedStorage buffers,
+ *  except the Bluefruit client service and characteristics, which belong to the
+ *  Bluefruit stack. Stack use is not included; see NEO_BOUNDED_RAM in
+ *  neosensory_bluefruit_config.h.
+ */
+#define NEO_BOUNDED_RAM_BYTES (sizeof(NeosensoryBluefruit) - sizeof(BLEClientService) \
+    - 2 * sizeof(BLEClientCharacteristic))
+#endif
+
 void connectCallbackWrapper(uint16_t conn_handle);
 void disconnectCallbackWrapper(uint16_t conn_handle, uint8_t reason);
 void readNotifyCallbackWrapper(BLEClientCharacteristic* chr, uint8_t* data, uint16_t len);
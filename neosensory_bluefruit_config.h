@@ -0,0 +1,193 @@
+/*
+ * Copyright 2020 Neosensory, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Please note that while this Neosensory SDK has an Apache 2.0 license,
+ * usage of the Neosensory API to interface with Neosensory products is
+ * still  subject to the Neosensory developer terms of service located at:
+ * https://neosensory.com/legal/dev-terms-service/
+ */
+
+/*
+    NeosensoryBluefruitConfig.h - Compile time configuration of the
+    NeosensoryBluefruit library. Edit the defaults below, or define any
+    of these before this file is included (e.g. with -D build flags).
+*/
+
+#ifndef NeosensoryBluefruitConfig_h
+#define NeosensoryBluefruitConfig_h
+
+/* Memory */
+
+/** @brief Set to 1 to keep all library state in fixed-size buffers.
+ *  @note Every buffer is then part of the NeosensoryBluefruit object and
+ *  nothing is allocated from the heap, at the cost of supporting at most
+ *  NEO_MAX_MOTORS motors. NEO_BOUNDED_RAM_BYTES in neosensory_bluefruit.h is
+ *  the RAM a NeosensoryBluefruit object then uses, taken from sizeof the
+ *  object. The buffers that replace heap allocations are grouped in
+ *  NeoBoundedStorage; the rest is the device list, the JSON buffer, the event
+ *  handlers, the button and LED state and the scalar members. With the defaults
+ *  below on the nRF52 it is 2753 bytes, of which NeoBoundedStorage is 1316.
+ *  It does not include:
+ *  - the Bluefruit client service and two characteristics the object holds,
+ *    which belong to the Bluefruit stack.
+ *  - stack. The worst case, sending a full packet of frames with
+ *    vibrateMotors(), is about NEO_MAX_MOTORS * 42 * 6 bytes (about 1 KB).
+ */
+#ifndef NEO_BOUNDED_RAM
+#define NEO_BOUNDED_RAM 0
+#endif
+
+/** @brief Max number of motors when NEO_BOUNDED_RAM is set. */
+#ifndef NEO_MAX_MOTORS
+#define NEO_MAX_MOTORS 4
+#endif
+
+/** @brief Size of the buffer holding a CLI JSON message from the wristband.
+ *  @note Longer messages are discarded.
+ */
+#ifndef NEO_JSON_BUFFER_SIZE
+#define NEO_JSON_BUFFER_SIZE 256
+#endif
+
+/** @brief Entries in each motor's calibration lookup table.
+ *  @note Smaller tables save RAM at the cost of intensity resolution.
+ */
+#ifndef NEO_CALIBRATION_TABLE_SIZE
+#define NEO_CALIBRATION_TABLE_SIZE 256
+#endif
+
+/** @brief Max points in a piecewise calibration curve. */
+#ifndef NEO_CURVE_MAX_POINTS
+#define NEO_CURVE_MAX_POINTS 8
+#endif
+
+/** @brief Slots in the hash table of allowed or denied device addresses.
+ *  @note Must be a power of two. Holds up to 3/4 as many addresses, at 8 bytes
+ *  per slot. Raise it (e.g. to 512) for dense deployments with hundreds of devices.
+ */
+#ifndef NEO_ADDRESS_SET_CAPACITY
+#define NEO_ADDRESS_SET_CAPACITY 64
+#endif
+
+/** @brief Max channels (motors) a NeosensoryFrameResampler can hold. */
+#ifndef NEO_RESAMPLER_MAX_CHANNELS
+#define NEO_RESAMPLER_MAX_CHANNELS 8
+#endif
+
+/** @brief Number of input samples a NeosensoryFrameResampler keeps.
+ *  @note Samples pushed beyond this without pulling frames drop the oldest,
+ *  and the frames they covered with them. The default covers about 10 frames of
+ *  16 ms from a 100 Hz source, so pull frames as samples arrive. To push
+ *  samples for a whole packet (max_frames_per_bt_package(), 42 frames for
+ *  4 motors) before pulling it, set this to at least the samples arriving
+ *  in that time plus 2, e.g. 42 * 16 ms at 100 Hz + 2 = 70. RAM and the
+ *  time to render each frame grow with it.
+ */
+#ifndef NEO_RESAMPLER_HISTORY
+#define NEO_RESAMPLER_HISTORY 16
+#endif
+
+/* Events */
+
+/** @brief Max handlers subscribed to each type of event. */
+#ifndef NEO_MAX_SUBSCRIBERS
+#define NEO_MAX_SUBSCRIBERS 4
+#endif
+
+/** @brief Number of buttons whose gestures are decoded. */
+#ifndef NEO_MAX_BUTTONS
+#define NEO_MAX_BUTTONS 4
+#endif
+
+/** @brief Button reports closer together than this are part of the same press.
+ *  @note Must be shorter than the gap between quick presses. With
+ *  NEO_BUTTON_REPORTS_REPEAT, must also be longer than the interval at which
+ *  the wristband repeats the report of a held button.
+ */
+#ifndef NEO_BUTTON_DEBOUNCE_MS
+#define NEO_BUTTON_DEBOUNCE_MS 150
+#endif
+
+/** @brief Max time between the starts of the two presses of a double press. */
+#ifndef NEO_BUTTON_DOUBLE_PRESS_MS
+#define NEO_BUTTON_DOUBLE_PRESS_MS 400
+#endif
+
+/** @brief Time a button must be held to be a long press. */
+#ifndef NEO_BUTTON_LONG_PRESS_MS
+#define NEO_BUTTON_LONG_PRESS_MS 800
+#endif
+
+/** @brief Set to 1 if the wristband firmware repeats a button's report while
+ *  it is held, more often than every NEO_BUTTON_DEBOUNCE_MS.
+ *  @note The wristband reports presses but not releases, and the developer API
+ *  does not document whether a held button is reported again, so by default no
+ *  long presses are published. When set, update() publishes a long press once a
+ *  press has run for NEO_BUTTON_LONG_PRESS_MS with its reports still repeating.
+ */
+#ifndef NEO_BUTTON_REPORTS_REPEAT
+#define NEO_BUTTON_REPORTS_REPEAT 0
+#endif
+
+/* Link */
+
+/** @brief Estimated radio-on time per packet sent, in microseconds.
+ *  @note Covers radio ramp-up, inter-frame spacing, the link layer acknowledgement
+ *  and packet headers. Used by NeosensoryBluefruit::getLinkStats().
+ */
+#ifndef NEO_RADIO_PACKET_US
+#define NEO_RADIO_PACKET_US 400
+#endif
+
+/** @brief Estimated radio-on time per byte of payload, in microseconds.
+ *  @note 8 on the 1 Mbps PHY, 4 on the 2 Mbps PHY.
+ */
+#ifndef NEO_RADIO_BYTE_US
+#define NEO_RADIO_BYTE_US 8
+#endif
+
+/* LEDs */
+
+/** @brief Least time between the writes of LED updates sent by LED animations. */
+#ifndef NEO_LED_MIN_INTERVAL_MS
+#define NEO_LED_MIN_INTERVAL_MS 50
+#endif
+
+/** @brief Longest an LED update waits to share a write with a motor packet.
+ *  @note Set to 0 to send LED updates as soon as they are due.
+ */
+#ifndef NEO_LED_PIGGYBACK_MS
+#define NEO_LED_PIGGYBACK_MS 32
+#endif
+
+/* Feature groups. Set any of these to 0 to compile the feature out. */
+
+#ifndef NEO_ENABLE_LEDS
+#define NEO_ENABLE_LEDS 1 /**< setLeds(), getLeds() and LED animations */
+#endif
+
+#ifndef NEO_ENABLE_BUTTONS
+#define NEO_ENABLE_BUTTONS 1 /**< setButtonResponse() and button press callbacks */
+#endif
+
+#ifndef NEO_ENABLE_LRA
+#define NEO_ENABLE_LRA 1 /**< setLRAMode() and getLRAMode() */
+#endif
+
+#ifndef NEO_ENABLE_THRESHOLDS
+#define NEO_ENABLE_THRESHOLDS 1 /**< setMotorThreshold() and getMotorThreshold() */
+#endif
+
+#endif
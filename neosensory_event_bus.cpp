@@ -0,0 +1,176 @@
+/*
+ * Copyright 2020 Neosensory, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Please note that while this Neosensory SDK has an Apache 2.0 license,
+ * usage of the Neosensory API to interface with Neosensory products is
+ * still  subject to the Neosensory developer terms of service located at:
+ * https://neosensory.com/legal/dev-terms-service/
+ */
+
+/*
+	NeosensoryEventBus.cpp - Fixed-size dispatcher of wristband events
+	to multiple subscribers, and a decoder of button gestures.
+*/
+
+#include "neosensory_event_bus.h"
+#include <string.h>
+
+
+/* Event Bus */
+
+NeosensoryEventBus::NeosensoryEventBus(void) {
+	memset(subscribers_, 0, sizeof(subscribers_));
+	memset(counts_, 0, sizeof(counts_));
+	dispatching_ = 0;
+	removed_ = false;
+}
+
+bool NeosensoryEventBus::subscribe(
+	NeoEventType type, NeoEventHandler handler, void* context) {
+	if (type >= NEO_EVENT_TYPE_COUNT || handler == NULL) {
+		return false;
+	}
+	Subscriber* subscribers = subscribers_[type];
+	for (int i = 0; i < counts_[type]; i++) {
+		if (subscribers[i].handler == handler && subscribers[i].context == context) {
+			return true;
+		}
+	}
+	if (counts_[type] >= NEO_MAX_SUBSCRIBERS) {
+		return false;
+	}
+	subscribers[counts_[type]].handler = handler;
+	subscribers[counts_[type]].context = context;
+	counts_[type]++;
+	return true;
+}
+
+bool NeosensoryEventBus::unsubscribe(
+	NeoEventType type, NeoEventHandler handler, void* context) {
+	if (type >= NEO_EVENT_TYPE_COUNT) {
+		return false;
+	}
+	Subscriber* subscribers = subscribers_[type];
+	for (int i = 0; i < counts_[type]; i++) {
+		if (subscribers[i].handler == handler && subscribers[i].context == context) {
+			// Cleared rather than removed while publishing, so no handler is skipped
+			subscribers[i].handler = NULL;
+			removed_ = true;
+			if (dispatching_ == 0) {
+				compact(type);
+			}
+			return true;
+		}
+	}
+	return false;
+}
+
+size_t NeosensoryEventBus::subscribers(NeoEventType type) {
+	if (type >= NEO_EVENT_TYPE_COUNT) {
+		return 0;
+	}
+	size_t count = 0;
+	for (int i = 0; i < counts_[type]; i++) {
+		if (subscribers_[type][i].handler != NULL) {
+			count++;
+		}
+	}
+	return count;
+}
+
+/** @brief Removes cleared handlers of a type, keeping the others in order
+ */
+void NeosensoryEventBus::compact(NeoEventType type) {
+	Subscriber* subscribers = subscribers_[type];
+	uint8_t kept = 0;
+	for (int i = 0; i < counts_[type]; i++) {
+		if (subscribers[i].handler != NULL) {
+			subscribers[kept++] = subscribers[i];
+		}
+	}
+	counts_[type] = kept;
+}
+
+void NeosensoryEventBus::publish(const NeoEvent& event) {
+	if (event.type >= NEO_EVENT_TYPE_COUNT) {
+		return;
+	}
+	dispatching_++;
+	const Subscriber* subscribers = subscribers_[event.type];
+	for (int i = 0; i < counts_[event.type]; i++) {
+		if (subscribers[i].handler != NULL) {
+			subscribers[i].handler(event, subscribers[i].context);
+		}
+	}
+	dispatching_--;
+	if (dispatching_ == 0 && removed_) {
+		removed_ = false;
+		for (int type = 0; type < NEO_EVENT_TYPE_COUNT; type++) {
+			compact((NeoEventType)type);
+		}
+	}
+}
+
+
+/* Button Gestures */
+
+NeosensoryButtonGestures::NeosensoryButtonGestures(void) {
+	reset();
+}
+
+void NeosensoryButtonGestures::reset(void) {
+	memset(buttons_, 0, sizeof(buttons_));
+}
+
+size_t NeosensoryButtonGestures::report(
+	uint8_t button, uint32_t now_ms, NeoButtonGesture gestures[]) {
+	if (button >= NEO_MAX_BUTTONS) {
+		return 0;
+	}
+	Button& state = buttons_[button];
+	if (state.seen && now_ms - state.last_report_ms < NEO_BUTTON_DEBOUNCE_MS) {
+		// Bounce, or the wristband repeating a held button
+		state.last_report_ms = now_ms;
+		return 0;
+	}
+	size_t num_gestures = 0;
+	gestures[num_gestures++] = NEO_BUTTON_PRESS;
+	// A third quick press starts a new pair rather than completing another double press
+	bool is_double = state.seen && !state.was_double &&
+		now_ms - state.press_start_ms < NEO_BUTTON_DOUBLE_PRESS_MS;
+	if (is_double) {
+		gestures[num_gestures++] = NEO_BUTTON_DOUBLE_PRESS;
+	}
+	state.seen = true;
+	state.long_sent = false;
+	state.was_double = is_double;
+	state.press_start_ms = now_ms;
+	state.last_report_ms = now_ms;
+	return num_gestures;
+}
+
+size_t NeosensoryButtonGestures::poll(uint32_t now_ms, uint8_t buttons[]) {
+	size_t num_buttons = 0;
+	for (uint8_t i = 0; i < NEO_MAX_BUTTONS; i++) {
+		Button& state = buttons_[i];
+		if (state.seen && !state.long_sent &&
+			now_ms - state.last_report_ms < NEO_BUTTON_DEBOUNCE_MS &&
+			now_ms - state.press_start_ms >= NEO_BUTTON_LONG_PRESS_MS) {
+			state.long_sent = true;
+			buttons[num_buttons++] = i;
+		}
+	}
+	return num_buttons;
+}
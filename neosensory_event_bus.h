@@ -0,0 +1,188 @@
+/*
+ * Copyright 2020 Neosensory, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Please note that while this Neosensory SDK has an Apache 2.0 license,
+ * usage of the Neosensory API to interface with Neosensory products is
+ * still  subject to the Neosensory developer terms of service located at:
+ * https://neosensory.com/legal/dev-terms-service/
+ */
+
+/*
+    NeosensoryEventBus.h - Fixed-size dispatcher of wristband events
+    to multiple subscribers, and a decoder of button gestures.
+*/
+
+#ifndef NeosensoryEventBus_h
+#define NeosensoryEventBus_h
+
+#include <stddef.h>
+#include <stdint.h>
+#include "neosensory_bluefruit_config.h"
+
+/** @brief Types of events published by NeosensoryBluefruit.
+ */
+enum NeoEventType {
+    NEO_EVENT_CONNECTED = 0, /**< Connected to a wristband, see NeoEvent::connected. */
+    NEO_EVENT_DISCONNECTED = 1, /**< Disconnected from a wristband, see NeoEvent::disconnected. */
+    NEO_EVENT_AUTHORIZED = 2, /**< Developer options were authorized. No payload. */
+    NEO_EVENT_BATTERY = 3, /**< Battery level received, see NeoEvent::battery. */
+    NEO_EVENT_BUTTON = 4, /**< Button gesture decoded, see NeoEvent::button. */
+    NEO_EVENT_NOTIFY = 5, /**< Raw data received from the wristband, see NeoEvent::notify. */
+    NEO_EVENT_TYPE_COUNT = 6 /**< Number of event types. */
+};
+
+/** @brief Gestures decoded from wristband button reports.
+ */
+enum NeoButtonGesture {
+    NEO_BUTTON_PRESS = 0, /**< A debounced press, published as soon as it starts. */
+    NEO_BUTTON_DOUBLE_PRESS = 1, /**< A second press soon after the start of the first, published after its NEO_BUTTON_PRESS. */
+    NEO_BUTTON_LONG_PRESS = 2 /**< A press held for NEO_BUTTON_LONG_PRESS_MS, published once per press.
+                                   Only published with NEO_BUTTON_REPORTS_REPEAT. */
+};
+
+/** @brief An event and its payload. Only the payload matching type is valid.
+ */
+struct NeoEvent {
+    NeoEventType type; /**< Type of the event. */
+    uint32_t time_ms; /**< millis() when the event was published. */
+    union {
+        struct {
+            bool success; /**< True if all services and characteristics were found. */
+        } connected;
+        struct {
+            uint16_t conn_handle; /**< Connection handle disconnected from. */
+            uint8_t reason; /**< Reason for the disconnect. */
+        } disconnected;
+        struct {
+            float percent; /**< Charge left in the battery, in percent. */
+        } battery;
+        struct {
+            uint8_t button; /**< Id of the button. */
+            NeoButtonGesture gesture; /**< Gesture decoded. */
+        } button;
+        struct {
+            const uint8_t* data; /**< Data received. Only valid during the handler call. */
+            uint16_t len; /**< Length of data. */
+        } notify;
+    };
+};
+
+/** @brief Function called with each event of a type it is subscribed to.
+ *  @param[in] event The event.
+ *  @param[in] context The pointer given when subscribing.
+ */
+typedef void (*NeoEventHandler)(const NeoEvent& event, void* context);
+
+/** @brief Dispatches events to the handlers subscribed to their type.
+ *  @note Subscribers are kept in a fixed array per event type, so publishing
+ *  only visits the handlers of that one type and nothing is allocated. Each
+ *  type holds up to NEO_MAX_SUBSCRIBERS handlers.
+ */
+class NeosensoryEventBus
+{
+  public:
+    /** @brief Constructor for new NeosensoryEventBus object, with no subscribers.
+     */
+    NeosensoryEventBus(void);
+
+    /** @brief Subscribe a handler to a type of event.
+     *  @param[in] type Type of event to handle.
+     *  @param[in] handler Function to call with each event of that type.
+     *  @param[in] context Pointer passed to handler, e.g. an object to forward the event to.
+     *  @return True if subscribed or already subscribed, false if the type already has
+     *  NEO_MAX_SUBSCRIBERS handlers.
+     */
+    bool subscribe(NeoEventType type, NeoEventHandler handler, void* context=NULL);
+
+    /** @brief Unsubscribe a handler from a type of event.
+     *  @param[in] type Type of event the handler was subscribed to.
+     *  @param[in] handler The handler.
+     *  @param[in] context The context the handler was subscribed with.
+     *  @return True if the handler was subscribed.
+     *  @note Safe to call from a handler, including to unsubscribe itself.
+     */
+    bool unsubscribe(NeoEventType type, NeoEventHandler handler, void* context=NULL);
+
+    /** @brief Get the number of handlers subscribed to a type of event.
+     *  @param[in] type Type of event.
+     *  @return Number of handlers.
+     */
+    size_t subscribers(NeoEventType type);
+
+    /** @brief Call every handler subscribed to the event's type, in the order they subscribed.
+     *  @param[in] event The event to publish.
+     */
+    void publish(const NeoEvent& event);
+
+  private:
+    struct Subscriber {
+        NeoEventHandler handler;
+        void* context;
+    };
+    Subscriber subscribers_[NEO_EVENT_TYPE_COUNT][NEO_MAX_SUBSCRIBERS];
+    uint8_t counts_[NEO_EVENT_TYPE_COUNT];
+    uint8_t dispatching_;
+    bool removed_;
+    void compact(NeoEventType type);
+};
+
+/** @brief Decodes presses, double presses and long presses from button reports.
+ *  @note The wristband only reports that a button is pressed, not when it is
+ *  released, so a press is a run of reports of one button, each within
+ *  NEO_BUTTON_DEBOUNCE_MS of the last. That debounces the button, and on firmware
+ *  that repeats the report of a held button, keeps a held button one press that
+ *  poll() can time as a long press. Holds the state of up to NEO_MAX_BUTTONS buttons.
+ */
+class NeosensoryButtonGestures
+{
+  public:
+    /** @brief Constructor for new NeosensoryButtonGestures object, with no buttons pressed.
+     */
+    NeosensoryButtonGestures(void);
+
+    /** @brief Forget any press in progress.
+     */
+    void reset(void);
+
+    /** @brief Decode a button report.
+     *  @param[in] button Id of the button reported. Ids of NEO_MAX_BUTTONS or more are ignored.
+     *  @param[in] now_ms Time of the report, from millis().
+     *  @param[out] gestures Array of at least 2 gestures to fill.
+     *  @return Number of gestures the report completes, in the order to publish them.
+     *  Never a long press, see poll().
+     */
+    size_t report(uint8_t button, uint32_t now_ms, NeoButtonGesture gestures[]);
+
+    /** @brief Find presses that have just become long presses.
+     *  @param[in] now_ms The current time, from millis().
+     *  @param[out] buttons Array of at least NEO_MAX_BUTTONS ids to fill.
+     *  @return Number of buttons whose press started at least NEO_BUTTON_LONG_PRESS_MS
+     *  ago and was last reported within NEO_BUTTON_DEBOUNCE_MS, each returned once per press.
+     *  @note Call this often, so a long press is found as soon as it is long enough.
+     */
+    size_t poll(uint32_t now_ms, uint8_t buttons[]);
+
+  private:
+    struct Button {
+        bool seen;
+        bool long_sent;
+        bool was_double;
+        uint32_t press_start_ms;
+        uint32_t last_report_ms;
+    };
+    Button buttons_[NEO_MAX_BUTTONS];
+};
+
+#endif
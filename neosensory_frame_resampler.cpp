@@ -0,0 +1,227 @@
+/*
+ * Copyright 2020 Neosensory, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Please note that while this Neosensory SDK has an Apache 2.0 license,
+ * usage of the Neosensory API to interface with Neosensory products is
+ * still  subject to the Neosensory developer terms of service located at:
+ * https://neosensory.com/legal/dev-terms-service/
+ */
+
+/*
+	NeosensoryFrameResampler.cpp - Converts timestamped samples at any
+	rate into motor frames on the firmware's frame clock.
+*/
+
+#include "neosensory_frame_resampler.h"
+#include <string.h>
+
+NeosensoryFrameResampler::NeosensoryFrameResampler(
+	uint8_t num_channels, uint8_t frame_duration, NeoResampleMode mode) {
+	num_channels_ = num_channels < NEO_RESAMPLER_MAX_CHANNELS ?
+		num_channels : NEO_RESAMPLER_MAX_CHANNELS;
+	frame_duration_ = frame_duration > 0 ? frame_duration : 1;
+	mode_ = mode;
+	max_change_ = 0;
+	reset();
+}
+
+void NeosensoryFrameResampler::reset(void) {
+	oldest_ = 0;
+	num_samples_ = 0;
+	next_frame_time_ = 0;
+	has_output_ = false;
+}
+
+void NeosensoryFrameResampler::setMode(NeoResampleMode mode) {
+	mode_ = mode;
+}
+
+void NeosensoryFrameResampler::setMaxChangePerFrame(float max_change) {
+	max_change_ = max_change;
+}
+
+uint8_t NeosensoryFrameResampler::num_channels(void) {
+	return num_channels_;
+}
+
+uint8_t NeosensoryFrameResampler::frame_duration(void) {
+	return frame_duration_;
+}
+
+/** @brief Gets the slot of sample_times_ and sample_values_ holding a sample
+ *	@param[in] age_order 0 for the oldest sample, num_samples_ - 1 for the newest
+ */
+uint8_t NeosensoryFrameResampler::sampleSlot(uint8_t age_order) {
+	return (oldest_ + age_order) % NEO_RESAMPLER_HISTORY;
+}
+
+bool NeosensoryFrameResampler::pushSample(uint32_t timestamp, const float samples[]) {
+	uint8_t slot;
+	if (num_samples_ == 0) {
+		next_frame_time_ = timestamp;
+		slot = sampleSlot(0);
+		num_samples_ = 1;
+	} else {
+		int32_t since_newest = (int32_t)(timestamp - sample_times_[sampleSlot(num_samples_ - 1)]);
+		if (since_newest < 0) {
+			return false;
+		}
+		if (since_newest == 0) {
+			// Same timestamp as the newest sample: replace it
+			slot = sampleSlot(num_samples_ - 1);
+		} else if (num_samples_ < NEO_RESAMPLER_HISTORY) {
+			slot = sampleSlot(num_samples_);
+			num_samples_++;
+		} else {
+			slot = oldest_;
+			oldest_ = sampleSlot(1);
+		}
+	}
+	sample_times_[slot] = timestamp;
+	memcpy(sample_values_[slot], samples, sizeof(float) * num_channels_);
+	return true;
+}
+
+/** @brief Gets how far past a frame's time samples are needed to render it,
+ *	in milliseconds
+ */
+int32_t NeosensoryFrameResampler::lookahead(void) {
+	return mode_ == NEO_RESAMPLE_WINDOWED ? (frame_duration_ + 1) / 2 : 0;
+}
+
+/** @brief Moves the frame clock forward past frames whose samples have
+ *	already been dropped from the history
+ */
+void NeosensoryFrameResampler::skipUnrenderableFrames(void) {
+	int32_t behind = (int32_t)(sample_times_[oldest_] - next_frame_time_);
+	if (behind > 0) {
+		next_frame_time_ +=
+			(behind + frame_duration_ - 1) / frame_duration_ * frame_duration_;
+	}
+}
+
+size_t NeosensoryFrameResampler::framesAvailable(void) {
+	if (num_samples_ == 0) {
+		return 0;
+	}
+	skipUnrenderableFrames();
+	uint32_t newest_time = sample_times_[sampleSlot(num_samples_ - 1)];
+	int32_t ahead = (int32_t)(newest_time - next_frame_time_) - lookahead();
+	if (ahead < 0) {
+		return 0;
+	}
+	return ahead / frame_duration_ + 1;
+}
+
+size_t NeosensoryFrameResampler::pullFrames(float *frames[], size_t max_frames) {
+	size_t num_frames = framesAvailable();
+	if (num_frames > max_frames) {
+		num_frames = max_frames;
+	}
+	for (size_t i = 0; i < num_frames; i++) {
+		renderFrame(next_frame_time_, frames[i]);
+		next_frame_time_ += frame_duration_;
+	}
+	return num_frames;
+}
+
+/** @brief Integrates one channel of the linear interpolation of samples
+ *	between two times, holding the first and last samples beyond their times
+ *	@param[in] times Sample times, oldest first
+ *	@param[in] values Sample values, oldest first
+ *	@param[in] num_samples Number of samples, at least 1
+ *	@param[in] channel Channel to integrate
+ *	@param[in] lo Start of the interval
+ *	@param[in] hi End of the interval
+ */
+float integrateLinear(const float times[], const float* values[],
+	uint8_t num_samples, uint8_t channel, float lo, float hi) {
+	uint8_t last = num_samples - 1;
+	float total = 0;
+	if (lo < times[0]) {
+		float end = hi < times[0] ? hi : times[0];
+		total += values[0][channel] * (end - lo);
+	}
+	if (hi > times[last]) {
+		float start = lo > times[last] ? lo : times[last];
+		total += values[last][channel] * (hi - start);
+	}
+	for (uint8_t i = 0; i < last; i++) {
+		float x0 = times[i];
+		float x1 = times[i + 1];
+		float p = lo > x0 ? lo : x0;
+		float q = hi < x1 ? hi : x1;
+		if (p >= q) {
+			continue;
+		}
+		float v0 = values[i][channel];
+		float slope = (values[i + 1][channel] - v0) / (x1 - x0);
+		float vp = v0 + slope * (p - x0);
+		float vq = v0 + slope * (q - x0);
+		total += (vp + vq) / 2 * (q - p);
+	}
+	return total;
+}
+
+/** @brief Computes a single frame from the sample history
+ *	@param[in] frame_time Time of the frame on the frame clock
+ *	@param[out] frame Array of num_channels_ values to fill
+ */
+void NeosensoryFrameResampler::renderFrame(uint32_t frame_time, float frame[]) {
+	float times[NEO_RESAMPLER_HISTORY];
+	const float* values[NEO_RESAMPLER_HISTORY];
+	for (uint8_t i = 0; i < num_samples_; i++) {
+		uint8_t slot = sampleSlot(i);
+		times[i] = (float)(int32_t)(sample_times_[slot] - frame_time);
+		values[i] = sample_values_[slot];
+	}
+
+	if (mode_ == NEO_RESAMPLE_WINDOWED) {
+		float half_window = frame_duration_ / 2.0f;
+		for (uint8_t c = 0; c < num_channels_; c++) {
+			frame[c] = integrateLinear(times, values, num_samples_, c,
+				-half_window, half_window) / frame_duration_;
+		}
+	} else {
+		// Newest sample at or before the frame
+		int before = num_samples_ - 1;
+		while (before >= 0 && times[before] > 0) {
+			before--;
+		}
+		if (before < 0) {
+			memcpy(frame, values[0], sizeof(float) * num_channels_);
+		} else if (mode_ == NEO_RESAMPLE_HOLD || before == num_samples_ - 1) {
+			memcpy(frame, values[before], sizeof(float) * num_channels_);
+		} else {
+			float t = -times[before] / (times[before + 1] - times[before]);
+			for (uint8_t c = 0; c < num_channels_; c++) {
+				frame[c] = values[before][c] + t * (values[before + 1][c] - values[before][c]);
+			}
+		}
+	}
+
+	if (max_change_ > 0 && has_output_) {
+		for (uint8_t c = 0; c < num_channels_; c++) {
+			float change = frame[c] - last_output_[c];
+			if (change > max_change_) {
+				frame[c] = last_output_[c] + max_change_;
+			} else if (change < -max_change_) {
+				frame[c] = last_output_[c] - max_change_;
+			}
+		}
+	}
+	memcpy(last_output_, frame, sizeof(float) * num_channels_);
+	has_output_ = true;
+}
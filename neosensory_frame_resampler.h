@@ -0,0 +1,135 @@
+/*
+ * Copyright 2020 Neosensory, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Please note that while this Neosensory SDK has an Apache 2.0 license,
+ * usage of the Neosensory API to interface with Neosensory products is
+ * still  subject to the Neosensory developer terms of service located at:
+ * https://neosensory.com/legal/dev-terms-service/
+ */
+
+/*
+    NeosensoryFrameResampler.h - Converts timestamped samples at any
+    rate into motor frames on the firmware's frame clock.
+*/
+
+#ifndef NeosensoryFrameResampler_h
+#define NeosensoryFrameResampler_h
+
+#include <stddef.h>
+#include <stdint.h>
+#include "neosensory_bluefruit_config.h"
+
+/** @brief How a resampler computes a frame from the samples around it.
+ */
+enum NeoResampleMode {
+    NEO_RESAMPLE_HOLD = 0, /**< Latest sample at or before the frame. Adds no latency. */
+    NEO_RESAMPLE_LINEAR = 1, /**< Linear interpolation between the samples around the frame. */
+    NEO_RESAMPLE_WINDOWED = 2 /**< Average of the linear interpolation over one frame
+                                   centered on the frame. Suppresses aliasing when the input
+                                   is faster than the frame clock, at half a frame of latency. */
+};
+
+/** @brief Converts timestamped multi-channel samples arriving at any rate
+ *  (e.g. an IMU at 100 Hz or a distance sensor at 25 Hz) into frames on a
+ *  fixed frame clock, such as NeosensoryBluefruit::firmware_frame_duration().
+ *  @note Holds all state in fixed-size arrays and never allocates. Samples
+ *  are pushed with pushSample(), and completed frames are pulled in blocks
+ *  with pullFrames(), ready for NeosensoryBluefruit::vibrateMotors().
+ */
+class NeosensoryFrameResampler
+{
+  public:
+    /** @brief Constructor for new NeosensoryFrameResampler object
+     *  @param[in] num_channels Number of values in each sample and frame, up to
+     *  NEO_RESAMPLER_MAX_CHANNELS. Usually the number of motors.
+     *  @param[in] frame_duration Duration of each output frame in milliseconds.
+     *  @param[in] mode How frames are computed from the samples around them.
+     */
+    NeosensoryFrameResampler(uint8_t num_channels=4, uint8_t frame_duration=16,
+        NeoResampleMode mode=NEO_RESAMPLE_LINEAR);
+
+    /** @brief Discards all samples. The frame clock restarts at the next sample.
+     */
+    void reset(void);
+
+    /** @brief Set how frames are computed from the samples around them.
+     *  @param[in] mode The new resampling mode.
+     */
+    void setMode(NeoResampleMode mode);
+
+    /** @brief Limit how fast each channel may change.
+     *  @param[in] max_change Max change of a channel's value from one frame
+     *  to the next. A value of 0 or less disables the limit.
+     */
+    void setMaxChangePerFrame(float max_change);
+
+    /** @brief Add a sample to the resampler.
+     *  @param[in] timestamp Time of the sample in milliseconds, e.g. from millis().
+     *  @param[in] samples Array of num_channels values.
+     *  @return True if the sample was added, false if it is older than the
+     *  latest sample.
+     *  @note When more than NEO_RESAMPLER_HISTORY samples are pushed without
+     *  pulling frames, the oldest samples and their frames are dropped. See
+     *  NEO_RESAMPLER_HISTORY for the history a full packet of frames needs.
+     */
+    bool pushSample(uint32_t timestamp, const float samples[]);
+
+    /** @brief Get the number of frames that can be pulled.
+     *  @return Number of frames that the samples pushed so far fully determine.
+     */
+    size_t framesAvailable(void);
+
+    /** @brief Compute the next frames on the frame clock.
+     *  @param[out] frames Array of max_frames arrays, each of at least num_channels
+     *  values, to write frames into. This matches the layout taken by
+     *  NeosensoryBluefruit::vibrateMotors(float *intensities[], int num_frames).
+     *  @param[in] max_frames The most frames to write.
+     *  @return The number of frames written.
+     */
+    size_t pullFrames(float *frames[], size_t max_frames);
+
+    /** @brief Get number of channels
+     *  @return The number of values in each sample and frame.
+     */
+    uint8_t num_channels(void);
+
+    /** @brief Get frame duration in milliseconds.
+     *  @return Duration of each output frame in milliseconds.
+     */
+    uint8_t frame_duration(void);
+
+  private:
+    uint8_t num_channels_;
+    uint8_t frame_duration_;
+    NeoResampleMode mode_;
+    float max_change_;
+
+    /* Sample history, a ring buffer from oldest_ */
+    uint32_t sample_times_[NEO_RESAMPLER_HISTORY];
+    float sample_values_[NEO_RESAMPLER_HISTORY][NEO_RESAMPLER_MAX_CHANNELS];
+    uint8_t oldest_;
+    uint8_t num_samples_;
+    uint8_t sampleSlot(uint8_t age_order);
+
+    /* Frame clock */
+    uint32_t next_frame_time_;
+    bool has_output_;
+    float last_output_[NEO_RESAMPLER_MAX_CHANNELS];
+    int32_t lookahead(void);
+    void skipUnrenderableFrames(void);
+    void renderFrame(uint32_t frame_time, float frame[]);
+};
+
+#endif
@@ -0,0 +1,224 @@
+/*
+ * Copyright 2020 Neosensory, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Please note that while this Neosensory SDK has an Apache 2.0 license,
+ * usage of the Neosensory API to interface with Neosensory products is
+ * still  subject to the Neosensory developer terms of service located at:
+ * https://neosensory.com/legal/dev-terms-service/
+ */
+
+/*
+	NeosensoryHapticTrack.cpp - Compact binary format for pre-authored
+	motor frames, with an encoder and a streaming decoder.
+*/
+
+#include "neosensory_haptic_track.h"
+#include <string.h>
+
+#define NEO_TRACK_MAX_REPEAT 128
+#define NEO_TRACK_CHANGE_FLAG 0x80
+
+
+/* Encoding */
+
+size_t neoMaxEncodedTrackSize(uint32_t num_frames, uint8_t num_motors) {
+	return NEO_TRACK_HEADER_SIZE + (size_t)num_frames * (1 + num_motors);
+}
+
+size_t neoEncodeTrack(const uint8_t frames[], uint32_t num_frames, uint8_t num_motors,
+	uint8_t frame_duration, uint8_t track[], size_t track_len) {
+	if (num_motors == 0 || num_motors > NEO_TRACK_MAX_MOTORS ||
+		track_len < NEO_TRACK_HEADER_SIZE) {
+		return 0;
+	}
+	uint8_t* p = track;
+	uint8_t* end = track + track_len;
+	*p++ = 'N';
+	*p++ = 'H';
+	*p++ = 'T';
+	*p++ = NEO_TRACK_VERSION;
+	*p++ = num_motors;
+	*p++ = frame_duration;
+	*p++ = 0;
+	*p++ = 0;
+	for (int i = 0; i < 4; i++) {
+		*p++ = (num_frames >> (8 * i)) & 0xFF;
+	}
+
+	uint8_t previous[NEO_TRACK_MAX_MOTORS];
+	memset(previous, 0, sizeof(previous));
+	uint32_t repeats = 0;
+	for (uint32_t f = 0; f <= num_frames; f++) {
+		const uint8_t* frame = frames + (size_t)f * num_motors;
+		uint8_t mask = 0;
+		if (f < num_frames) {
+			for (uint8_t m = 0; m < num_motors; m++) {
+				if (frame[m] != previous[m]) {
+					mask |= 1 << m;
+				}
+			}
+			if (mask == 0 && repeats < NEO_TRACK_MAX_REPEAT) {
+				repeats++;
+				continue;
+			}
+		}
+		// Frame differs, the run is full or the track ended: flush the run
+		if (repeats > 0) {
+			if (p >= end) {
+				return 0;
+			}
+			*p++ = repeats - 1;
+			repeats = 0;
+		}
+		if (f == num_frames) {
+			break;
+		}
+		if (mask == 0) {
+			repeats = 1;
+			continue;
+		}
+		if (p >= end) {
+			return 0;
+		}
+		*p++ = NEO_TRACK_CHANGE_FLAG | mask;
+		for (uint8_t m = 0; m < num_motors; m++) {
+			if (mask & (1 << m)) {
+				if (p >= end) {
+					return 0;
+				}
+				*p++ = frame[m];
+				previous[m] = frame[m];
+			}
+		}
+	}
+	return p - track;
+}
+
+
+/* Decoding */
+
+NeosensoryTrackReader::NeosensoryTrackReader(void) {
+	track_ = NULL;
+	track_len_ = 0;
+	num_frames_ = 0;
+	num_motors_ = 0;
+	frame_duration_ = 0;
+	rewind();
+}
+
+bool NeosensoryTrackReader::open(const uint8_t track[], size_t track_len) {
+	track_ = NULL;
+	num_frames_ = 0;
+	if (track_len < NEO_TRACK_HEADER_SIZE || track[0] != 'N' || track[1] != 'H' ||
+		track[2] != 'T' || track[3] != NEO_TRACK_VERSION ||
+		track[4] == 0 || track[4] > NEO_TRACK_MAX_MOTORS) {
+		rewind();
+		return false;
+	}
+	track_ = track;
+	track_len_ = track_len;
+	num_motors_ = track[4];
+	frame_duration_ = track[5];
+	num_frames_ = (uint32_t)track[8] | (uint32_t)track[9] << 8 |
+		(uint32_t)track[10] << 16 | (uint32_t)track[11] << 24;
+	rewind();
+	return true;
+}
+
+void NeosensoryTrackReader::rewind(void) {
+	offset_ = NEO_TRACK_HEADER_SIZE;
+	position_ = 0;
+	repeats_left_ = 0;
+	corrupt_ = track_ == NULL;
+	memset(frame_, 0, sizeof(frame_));
+}
+
+uint8_t NeosensoryTrackReader::num_motors(void) {
+	return num_motors_;
+}
+
+uint8_t NeosensoryTrackReader::frame_duration(void) {
+	return frame_duration_;
+}
+
+uint32_t NeosensoryTrackReader::num_frames(void) {
+	return num_frames_;
+}
+
+uint32_t NeosensoryTrackReader::position(void) {
+	return position_;
+}
+
+bool NeosensoryTrackReader::finished(void) {
+	return corrupt_ || position_ >= num_frames_;
+}
+
+/** @brief Advances frame_ to the next frame of the track
+ *	@return False if the track ends early or is malformed
+ */
+bool NeosensoryTrackReader::decodeFrame(void) {
+	if (repeats_left_ > 0) {
+		repeats_left_--;
+		return true;
+	}
+	if (offset_ >= track_len_) {
+		return false;
+	}
+	uint8_t control = track_[offset_++];
+	if (!(control & NEO_TRACK_CHANGE_FLAG)) {
+		repeats_left_ = control;
+		return true;
+	}
+	for (uint8_t m = 0; m < num_motors_; m++) {
+		if (control & (1 << m)) {
+			if (offset_ >= track_len_) {
+				return false;
+			}
+			frame_[m] = track_[offset_++];
+		}
+	}
+	return true;
+}
+
+bool NeosensoryTrackReader::seek(uint32_t frame) {
+	if (frame < position_) {
+		rewind();
+	}
+	if (frame > num_frames_) {
+		frame = num_frames_;
+	}
+	while (position_ < frame && !corrupt_) {
+		if (!decodeFrame()) {
+			corrupt_ = true;
+			break;
+		}
+		position_++;
+	}
+	return !corrupt_;
+}
+
+size_t NeosensoryTrackReader::read(uint8_t frames[], size_t max_frames) {
+	size_t num_read = 0;
+	while (num_read < max_frames && !finished()) {
+		if (!decodeFrame()) {
+			corrupt_ = true;
+			break;
+		}
+		memcpy(frames + num_read * num_motors_, frame_, num_motors_);
+		num_read++;
+		position_++;
+	}
+	return num_read;
+}
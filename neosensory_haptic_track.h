@@ -0,0 +1,151 @@
+/*
+ * Copyright 2020 Neosensory, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Please note that while this Neosensory SDK has an Apache 2.0 license,
+ * usage of the Neosensory API to interface with Neosensory products is
+ * still  subject to the Neosensory developer terms of service located at:
+ * https://neosensory.com/legal/dev-terms-service/
+ */
+
+/*
+    NeosensoryHapticTrack.h - Compact binary format for pre-authored
+    motor frames, with an encoder and a streaming decoder.
+
+    A track is a 12 byte header followed by a stream of operations:
+      bytes 0-3   'N', 'H', 'T', format version (1)
+      byte  4     number of motors, 1 to NEO_TRACK_MAX_MOTORS
+      byte  5     frame duration in milliseconds
+      bytes 6-7   reserved, 0
+      bytes 8-11  number of frames, little endian
+    Each operation starts with a control byte c:
+      c < 0x80    the previous frame repeats c + 1 times
+      c >= 0x80   one frame in which the motors in the mask c & 0x7F changed,
+                  followed by the new motor intensity of each of them, lowest
+                  motor first
+    The frame before the first one has every motor off.
+*/
+
+#ifndef NeosensoryHapticTrack_h
+#define NeosensoryHapticTrack_h
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define NEO_TRACK_HEADER_SIZE 12 /**< Bytes in a track header. */
+#define NEO_TRACK_MAX_MOTORS 7 /**< Max motors in a track, limited by the change mask. */
+#define NEO_TRACK_VERSION 1 /**< Track format version written by neoEncodeTrack(). */
+
+/** @brief Get the largest number of bytes a track can encode to.
+ *  @param[in] num_frames Number of frames in the track.
+ *  @param[in] num_motors Number of motors in each frame.
+ *  @return Size of a buffer that always fits the encoded track.
+ */
+size_t neoMaxEncodedTrackSize(uint32_t num_frames, uint8_t num_motors);
+
+/** @brief Encode motor frames into a track.
+ *  @param[in] frames Flattened array of num_frames * num_motors motor intensities,
+ *  between 0 and 255, i.e. already in motor space.
+ *  @param[in] num_frames Number of frames.
+ *  @param[in] num_motors Number of motors in each frame, up to NEO_TRACK_MAX_MOTORS.
+ *  @param[in] frame_duration Duration each frame plays for, in milliseconds.
+ *  @param[out] track Buffer to write the track to.
+ *  @param[in] track_len Length of track. neoMaxEncodedTrackSize() bytes always suffice.
+ *  @return Number of bytes written, or 0 if the buffer is too small or the
+ *  arguments are invalid.
+ */
+size_t neoEncodeTrack(const uint8_t frames[], uint32_t num_frames, uint8_t num_motors,
+    uint8_t frame_duration, uint8_t track[], size_t track_len);
+
+/** @brief Decodes a track a few frames at a time.
+ *  @note The track is read in place, so it can live in internal flash (e.g. a
+ *  const array) or in a memory-mapped file, and is never copied to RAM. Only
+ *  the previous frame and the current operation are kept.
+ */
+class NeosensoryTrackReader
+{
+  public:
+    /** @brief Constructor for new NeosensoryTrackReader object, with no track open.
+     */
+    NeosensoryTrackReader(void);
+
+    /** @brief Open a track and rewind to its first frame.
+     *  @param[in] track The encoded track. Must stay valid while it is read.
+     *  @param[in] track_len Length of track in bytes.
+     *  @return True if track has a valid header.
+     */
+    bool open(const uint8_t track[], size_t track_len);
+
+    /** @brief Go back to the first frame of the track.
+     */
+    void rewind(void);
+
+    /** @brief Move to a frame of the track.
+     *  @param[in] frame Index of the frame read() should decode next. Clamped to
+     *  the end of the track.
+     *  @return True unless the track is corrupt before that frame.
+     *  @note Decodes and discards the frames in between, starting over from the
+     *  first frame when moving backwards, so it costs time linear in the distance.
+     */
+    bool seek(uint32_t frame);
+
+    /** @brief Decode the next frames of the track.
+     *  @param[out] frames Flattened array of at least max_frames * num_motors() values
+     *  to write motor intensities to.
+     *  @param[in] max_frames The most frames to decode.
+     *  @return Number of frames decoded. Fewer than max_frames at the end of the
+     *  track or if the track is corrupt.
+     */
+    size_t read(uint8_t frames[], size_t max_frames);
+
+    /** @brief Check if every frame of the track has been read.
+     *  @return True if there are no frames left, or the track is corrupt.
+     */
+    bool finished(void);
+
+    /** @brief Get number of motors
+     *  @return The number of motor intensities in each frame of the track.
+     */
+    uint8_t num_motors(void);
+
+    /** @brief Get frame duration in milliseconds.
+     *  @return Duration each frame of the track was authored to play for.
+     */
+    uint8_t frame_duration(void);
+
+    /** @brief Get number of frames
+     *  @return The number of frames in the track.
+     */
+    uint32_t num_frames(void);
+
+    /** @brief Get the index of the next frame read() will decode.
+     *  @return Index of the next frame.
+     */
+    uint32_t position(void);
+
+  private:
+    const uint8_t* track_;
+    size_t track_len_;
+    size_t offset_;
+    uint32_t num_frames_;
+    uint32_t position_;
+    uint8_t num_motors_;
+    uint8_t frame_duration_;
+    uint8_t repeats_left_;
+    bool corrupt_;
+    uint8_t frame_[NEO_TRACK_MAX_MOTORS];
+    bool decodeFrame(void);
+};
+
+#endif